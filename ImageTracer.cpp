@@ -8,6 +8,14 @@
 #pragma message("-> Compiling with OpenMP")
 #endif
 
+// Whole file is compiled as native code (see project), so fitting doesn't switch between
+// managed and native code for each kernel call. Kernels rely on operations not being
+// contracted to FMA instructions, vector and scalar versions must round the same way.
+#ifdef _MANAGED
+#error ImageTracer.cpp needs to be compiled as native code
+#endif
+#pragma fp_contract(off)
+
 
 namespace ImageTracer 
 {
@@ -22,6 +30,86 @@ TraceException::TraceException(const char* msg)
 { }
 
 
+//*****************************************************************************
+
+Arena::Arena()
+	: _block(0)
+	, _used(0)
+{ }
+
+void* Arena::Allocate(const size_t bytes, const size_t align)
+{
+	if (!_blocks.empty())
+	{
+		// Blocks are aligned for any type
+		const size_t offset = (_used + align - 1) & ~(align - 1);
+		if (offset + bytes <= _sizes[_block])
+		{
+			_used = offset + bytes;
+			return _blocks[_block].get() + offset;
+		}
+	}
+
+	// Moving on to next block, inserting a new one if it's missing or too small
+	const size_t next = _blocks.empty() ? 0 : _block + 1;
+	if ((next == _blocks.size()) || (_sizes[next] < bytes))
+	{
+		const size_t size = (bytes > _block_size) ? bytes : _block_size;
+		_blocks.insert(_blocks.begin() + next, std::unique_ptr<char[]>(new char[size]));
+		_sizes.insert(_sizes.begin() + next, size);
+		_starts.resize(_blocks.size());
+		for (size_t b = next; b < _blocks.size(); ++b)
+			_starts[b] = (b > 0) ? _starts[b - 1] + _sizes[b - 1] : 0;
+	}
+
+	_block = next;
+	_used = bytes;
+	return _blocks[_block].get();
+}
+
+size_t Arena::Mark() const
+{
+	return _blocks.empty() ? 0 : _starts[_block] + _used;
+}
+
+void Arena::Rewind(const size_t mark)
+{
+	if (_blocks.empty())
+		return;
+
+	// Blocks after current one only get inserted beyond any mark still valid
+	size_t b = _block;
+	while ((b > 0) && (_starts[b] > mark))
+		--b;
+	_block = b;
+	_used = mark - _starts[b];
+}
+
+
+//*****************************************************************************
+
+CoordList::CoordList()
+{ }
+
+CoordList::CoordList(Arena* arena)
+	: Vector<int, ArenaAllocator<int> >(ArenaAllocator<int>(arena))
+{ }
+
+CodeList::CodeList()
+{ }
+
+CodeList::CodeList(Arena* arena)
+	: Vector<signed char, ArenaAllocator<signed char> >(ArenaAllocator<signed char>(arena))
+{ }
+
+IndexStack::IndexStack()
+{ }
+
+IndexStack::IndexStack(Arena* arena)
+	: Vector<int, ArenaAllocator<int> >(ArenaAllocator<int>(arena))
+{ }
+
+
 //*****************************************************************************
 
 Point::Point()
@@ -94,16 +182,85 @@ SegmentList& SegmentList::Concat(const SegmentList& segments)
 //*****************************************************************************
 
 Poly::Poly()
+	: IsHole(false)
+	, StartX(0)
+	, StartY(0)
 { }
 
 Poly::Poly(const Poly& poly)
 	: Segments(poly.Segments)
+	, BoundingBox(poly.BoundingBox)
+	, IsHole(poly.IsHole)
+	, HoleChildren(poly.HoleChildren)
+	, StartX(poly.StartX)
+	, StartY(poly.StartY)
+{ }
+
+Poly::Poly(Poly&& poly) noexcept
+	: Segments(std::move(poly.Segments))
+	, BoundingBox(poly.BoundingBox)
+	, IsHole(poly.IsHole)
+	, HoleChildren(std::move(poly.HoleChildren))
+	, StartX(poly.StartX)
+	, StartY(poly.StartY)
 { }
 
 Poly::Poly(const SegmentList& segments)
 	: Segments(segments)
+	, IsHole(false)
+	, StartX(0)
+	, StartY(0)
+{ }
+
+Poly::Poly(const SegmentList& segments, const BBox& bbox, const bool hole, const IntList& holechildren)
+	: Segments(segments)
+	, BoundingBox(bbox)
+	, IsHole(hole)
+	, HoleChildren(holechildren)
+	, StartX(bbox.coords[0])
+	, StartY(bbox.coords[1])
+{ }
+
+Poly::Poly(SegmentList&& segments, const BBox& bbox, const bool hole, IntList&& holechildren)
+	: Segments(std::move(segments))
+	, BoundingBox(bbox)
+	, IsHole(hole)
+	, HoleChildren(std::move(holechildren))
+	, StartX(bbox.coords[0])
+	, StartY(bbox.coords[1])
+{ }
+
+Poly::Poly(SegmentList&& segments, const BBox& bbox, const bool hole, IntList&& holechildren, const int startx, const int starty)
+	: Segments(std::move(segments))
+	, BoundingBox(bbox)
+	, IsHole(hole)
+	, HoleChildren(std::move(holechildren))
+	, StartX(startx)
+	, StartY(starty)
 { }
 
+Poly& Poly::operator=(const Poly& poly)
+{
+	Segments     = poly.Segments;
+	BoundingBox  = poly.BoundingBox;
+	IsHole       = poly.IsHole;
+	HoleChildren = poly.HoleChildren;
+	StartX       = poly.StartX;
+	StartY       = poly.StartY;
+	return *this;
+}
+
+Poly& Poly::operator=(Poly&& poly) noexcept
+{
+	Segments     = std::move(poly.Segments);
+	BoundingBox  = poly.BoundingBox;
+	IsHole       = poly.IsHole;
+	HoleChildren = std::move(poly.HoleChildren);
+	StartX       = poly.StartX;
+	StartY       = poly.StartY;
+	return *this;
+}
+
 
 //*****************************************************************************
 
@@ -115,11 +272,149 @@ Layer::Layer(const Layer& layer)
 	, ColorIndex(layer.ColorIndex)
 { }
 
+Layer::Layer(Layer&& layer) noexcept
+	: Polygons(std::move(layer.Polygons))
+	, ColorIndex(layer.ColorIndex)
+{ }
+
 Layer::Layer(const PolyList& polys, const int color_index)
 	: Polygons(polys)
 	, ColorIndex(color_index)
 { }
 
+Layer::Layer(PolyList&& polys, const int color_index)
+	: Polygons(std::move(polys))
+	, ColorIndex(color_index)
+{ }
+
+Layer& Layer::operator=(const Layer& layer)
+{
+	Polygons   = layer.Polygons;
+	ColorIndex = layer.ColorIndex;
+	return *this;
+}
+
+Layer& Layer::operator=(Layer&& layer) noexcept
+{
+	Polygons   = std::move(layer.Polygons);
+	ColorIndex = layer.ColorIndex;
+	return *this;
+}
+
+
+//*****************************************************************************
+
+FlatResult::FlatResult()
+{
+	LayerOffsets.push_back(0);
+	PolyOffsets.push_back(0);
+	HoleOffsets.push_back(0);
+}
+
+FlatResult::FlatResult(const LayerList& layers)
+{
+	int poly_count = 0, segment_count = 0, child_count = 0;
+	for (auto& l : layers)
+	{
+		poly_count += (int)l.Polygons.size();
+		for (auto& p : l.Polygons)
+		{
+			segment_count += (int)p.Segments.size();
+			child_count += (int)p.HoleChildren.size();
+		}
+	}
+
+	LayerColors.reserve(layers.size());
+	LayerOffsets.reserve(layers.size() + 1);
+	PolyOffsets.reserve(poly_count + 1);
+	PolyHoles.reserve(poly_count);
+	PolyBBoxes.reserve(4 * poly_count);
+	HoleOffsets.reserve(poly_count + 1);
+	HoleChildren.reserve(child_count);
+	Segments.reserve(segment_count);
+
+	LayerOffsets.push_back(0);
+	PolyOffsets.push_back(0);
+	HoleOffsets.push_back(0);
+	for (auto& l : layers)
+	{
+		for (auto& p : l.Polygons)
+		{
+			Segments.insert(Segments.end(), p.Segments.begin(), p.Segments.end());
+			PolyOffsets.push_back((int)Segments.size());
+			PolyHoles.push_back(p.IsHole ? 1 : 0);
+			PolyBBoxes.insert(PolyBBoxes.end(), p.BoundingBox.coords, p.BoundingBox.coords + 4);
+			HoleChildren.insert(HoleChildren.end(), p.HoleChildren.begin(), p.HoleChildren.end());
+			HoleOffsets.push_back((int)HoleChildren.size());
+		}
+		LayerColors.push_back(l.ColorIndex);
+		LayerOffsets.push_back((int)PolyHoles.size());
+	}
+}
+
+
+//*****************************************************************************
+
+void PolyPool::Give(PolyList& polys)
+{
+	_segments.clear();
+	_children.clear();
+
+	// Handed out from back, so first poly's storage goes last
+	for (int i = (int)polys.size() - 1; i >= 0; --i)
+	{
+		Poly& poly = polys[i];
+		if (poly.Segments.capacity() > 0)
+			_segments.push_back(std::move(poly.Segments));
+		if (poly.HoleChildren.capacity() > 0)
+			_children.push_back(std::move(poly.HoleChildren));
+	}
+
+	polys.clear();
+	if (polys.capacity() > _polys.capacity())
+		_polys.swap(polys);
+}
+
+void PolyPool::Reserve(const size_t count)
+{
+	_segments.reserve(count);
+	_children.reserve(count);
+}
+
+void PolyPool::Take(PolyList& polys)
+{
+	polys.swap(_polys);
+}
+
+void PolyPool::Take(SegmentList& segments)
+{
+	if (_segments.empty())
+		return;
+	segments.swap(_segments.back());
+	_segments.pop_back();
+	segments.clear();
+}
+
+void PolyPool::Take(IntList& children)
+{
+	if (_children.empty())
+		return;
+	children.swap(_children.back());
+	_children.pop_back();
+	children.clear();
+}
+
+
+//*****************************************************************************
+
+EdgeNode::EdgeNode()
+{ }
+
+EdgeNode::EdgeNode(const int _index, const byte _type)
+	: index(_index)
+	, type(_type)
+{ }
+
 
 //*****************************************************************************
 
@@ -154,353 +449,2395 @@ bool BBox::Includes(const BBox& childbbox) const
 
 Path::Path()
 	: isholepath(false)
+	, startx(0)
+	, starty(0)
+{ }
+
+Path::Path(Arena* arena)
+	: xs(arena)
+	, ys(arena)
+	, linesegments(arena)
+	, isholepath(false)
+	, startx(0)
+	, starty(0)
 { }
 
 Path::Path(const Path& p)
-	: points(p.points)
+	: xs(p.xs)
+	, ys(p.ys)
 	, linesegments(p.linesegments)
 	, boundingbox(p.boundingbox)
 	, isholepath(p.isholepath)
-//TODO: , holechildren(p.holechildren)
+	, holechildren(p.holechildren)
 	, segments(p.segments)
+	, startx(p.startx)
+	, starty(p.starty)
 { }
 
+Path::Path(Path&& p) noexcept
+	: xs(std::move(p.xs))
+	, ys(std::move(p.ys))
+	, linesegments(std::move(p.linesegments))
+	, boundingbox(p.boundingbox)
+	, isholepath(p.isholepath)
+	, holechildren(std::move(p.holechildren))
+	, segments(std::move(p.segments))
+	, startx(p.startx)
+	, starty(p.starty)
+{ }
 
-//*****************************************************************************
-
-#define INDEX(row,col,width) (((row)*width)+(col))
+Path& Path::operator=(const Path& p)
+{
+	xs           = p.xs;
+	ys           = p.ys;
+	linesegments = p.linesegments;
+	boundingbox  = p.boundingbox;
+	isholepath   = p.isholepath;
+	holechildren = p.holechildren;
+	segments     = p.segments;
+	startx       = p.startx;
+	starty       = p.starty;
+	return *this;
+}
 
-// Traces color-indexed image data
-ImageTracer* ImageTracer::Trace(byte* pixels, const int width, const int height, const Options& options)
+Path& Path::operator=(Path&& p) noexcept
 {
-	ImageTracer* trc = nullptr;
-	try
-	{
-		trc = new ImageTracer();
-		if (trc)
-			trc->_Trace(pixels, width, height, options);
-	}
-	catch (...)
-	{
-		if (trc)
-			delete trc;
-		trc = nullptr;
-	}
-	return trc;
+	xs           = std::move(p.xs);
+	ys           = std::move(p.ys);
+	linesegments = std::move(p.linesegments);
+	boundingbox  = p.boundingbox;
+	isholepath   = p.isholepath;
+	holechildren = std::move(p.holechildren);
+	segments     = std::move(p.segments);
+	startx       = p.startx;
+	starty       = p.starty;
+	return *this;
 }
 
-ImageTracer::ImageTracer()
-{ }
+int Path::PointCount() const
+{
+	return (int)xs.size();
+}
 
-void ImageTracer::_Trace(byte* pixels, const int width, const int height, const Options& options)
+Point Path::PointAt(const int i) const
 {
-	const int length = width * height;
+	return Point(xs[i] * 0.5f, ys[i] * 0.5f);
+}
 
-	// Find min/max color indices
-	byte min = 255, max = 0;
-	byte* px = pixels;
-	for (int i = 0; i < length; ++i, ++px)
-	{
-		const byte b = *px;
-		if (b < min)
-			min = b;
-		if (b > max)
-			max = b;
-	}
-	if (min >= max)
-		throw new TraceException("Can't trace empty image");
-	if (max == 255)
-		throw new TraceException("Color index 255 is reserved, please adjust your input");
+void Path::AddPoint(const int x2, const int y2)
+{
+	xs.push_back(x2);
+	ys.push_back(y2);
+}
 
-	// Create new buffer with a 1px border around it, border uses color index 255
-	int bordered_width = width + 2;
-	int bordered_height = height + 2;
-	int bordered_length = bordered_width * bordered_height;
-	std::auto_ptr<byte> ap_bordered_pixels(new byte[bordered_length]);
-	byte* bordered_pixels = ap_bordered_pixels.get();
-	px = pixels;
-	byte* dest = bordered_pixels;
-	memset(dest, 255, bordered_width);
-	dest += bordered_width;
-	for (int row = 1; row <= height; ++row)
-	{
-		*dest = 255;
-		++dest;
+void Path::ReservePoints(const int count)
+{
+	xs.reserve(count);
+	ys.reserve(count);
+}
 
-		memcpy(dest, px, width);
-		dest += width;
-		px += width;
+int Path::Distance(const int start, const int end) const
+{
+	int d = end - start;
+	if (d < 0)
+		d += PointCount();
+	return d;
+}
 
-		*dest = 255;
-		++dest;
-	}
-	memset(dest, 255, bordered_width);
+int Path::Next(const int start, const int n) const
+{
+	int i = start + n;
+	if (i >= PointCount())
+		i -= PointCount();
+	return i;
+}
 
 
-	// Sequential layering
+//*****************************************************************************
 
-	// Loop over all color indices found
-#pragma omp parallel for shared(options, min, max, bordered_pixels, bordered_width, bordered_height, bordered_length)
-	for (int color_index = min; color_index <= max; ++color_index)
-	{
-		// layeringstep -> pathscan -> internodes -> batchtracepaths
-		std::auto_ptr<int> ap_layer(new int[bordered_length]);
-		int* layer = ap_layer.get();
-		_LayeringStep(bordered_pixels, bordered_width, bordered_height, (byte)color_index, layer);
-
-		PathList tracedlayer =
-			_BatchTracePaths(							
-				_InterNodes(								
-					_PathScan(
-						layer, 
-						bordered_width, 
-						bordered_height,
-						options.pathomit
-					),							
-					options							
-				),						
-				options.ltres,
-				options.qtres						
-			);
-	
-		// adding traced layer
-		PolyList polys;
-		for (auto p : tracedlayer)
-			polys.push_back(Poly(p.segments));
+PathList::PathList()
+{ }
 
-#	pragma omp critical
-		Layers.push_back(Layer(polys, color_index));
-	}
+PathList::PathList(Arena* arena)
+	: Vector<Path, ArenaAllocator<Path> >(ArenaAllocator<Path>(arena))
+{ }
 
-}
 
+//*****************************************************************************
 
-// 1. Color quantization
-// Using a form of k-means clustering repeatead options.colorquantcycles times. http://en.wikipedia.org/wiki/Color_quantization
-//=> Skipped for now
+// Window scanning kernels used by layering step. Project is built without /arch:AVX2,
+// AVX2 version is only used if CPU supports it.
+// Window k consists of above[k], above[k+1], below[k] and below[k+1], all windows 
+// in [start, count) not made of a single color index get their offset stored.
+// Returns number of offsets stored.
 
-// 2. Layer separation and edge detection
-//
-// Edge node types ( ▓: this layer or 1; ░: not this layer or 0 )
-//
-// 12  ░░  ▓░  ░▓  ▓▓  ░░  ▓░  ░▓  ▓▓  ░░  ▓░  ░▓  ▓▓  ░░  ▓░  ░▓  ▓▓
-//
-// 48  ░░  ░░  ░░  ░░  ░▓  ░▓  ░▓  ░▓  ▓░  ▓░  ▓░  ▓░  ▓▓  ▓▓  ▓▓  ▓▓
-//     0   1   2   3   4   5   6   7   8   9   10  11  12  13  14  15
-void ImageTracer::_LayeringStep(byte* pixels, const int width, const int height, const byte color_index, int* layer)
+static int _ScanWindows_Scalar(const byte* above, const byte* below, const int start, const int count, int* offsets)
 {
-	// Creating layers for each indexed color in arr
-	int length = width * height;
-
-	// Looping through all pixels and calculating edge node type
-	byte *src = pixels;
-	int* dest = layer;
-
-	memset(dest, 0, width*sizeof(int));
-	dest += width;
-
-	src += width;
-	for (int j = 1; j < height; j++)
+	int n = 0;
+	for (int k = start; k < count; ++k)
 	{
-		*dest = 0;
-		++dest;
+		if ((above[k] != above[k + 1]) || (below[k] != below[k + 1]) || (above[k + 1] != below[k + 1]))
+			offsets[n++] = k;
+	}
+	return n;
+}
 
-		++src;
-		for (int i = 1; i < width; ++i, ++src, ++dest)
+static int _ScanWindows_SSE2(const byte* above, const byte* below, const int start, const int count, int* offsets)
+{
+	int n = 0;
+	int k = start;
+	for (; k + 16 <= count; k += 16)
+	{
+		const __m128i a0 = _mm_loadu_si128((const __m128i*)(above + k));
+		const __m128i a1 = _mm_loadu_si128((const __m128i*)(above + k + 1));
+		const __m128i b0 = _mm_loadu_si128((const __m128i*)(below + k));
+		const __m128i b1 = _mm_loadu_si128((const __m128i*)(below + k + 1));
+		const __m128i uniform = _mm_and_si128(
+			_mm_and_si128(_mm_cmpeq_epi8(a0, a1), _mm_cmpeq_epi8(b0, b1)),
+			_mm_cmpeq_epi8(a1, b1)
+		);
+
+		unsigned long mask = (~(unsigned long)_mm_movemask_epi8(uniform)) & 0xFFFF;
+		unsigned long bit;
+		while (_BitScanForward(&bit, mask))
 		{
-			*dest =
-				(*((src-width)-1) == color_index ? 1 : 0) +
-				(*((src-width)  ) == color_index ? 2 : 0) +
-				(*( src       -1) == color_index ? 8 : 0) +
-				(*( src         ) == color_index ? 4 : 0)
-			;
+			offsets[n++] = k + (int)bit;
+			mask &= mask - 1;
 		}
 	}
+	return n + _ScanWindows_Scalar(above, below, k, count, offsets + n);
+}
 
+static int _ScanWindows_AVX2(const byte* above, const byte* below, const int start, const int count, int* offsets)
+{
+	int n = 0;
+	int k = start;
+	for (; k + 32 <= count; k += 32)
+	{
+		const __m256i a0 = _mm256_loadu_si256((const __m256i*)(above + k));
+		const __m256i a1 = _mm256_loadu_si256((const __m256i*)(above + k + 1));
+		const __m256i b0 = _mm256_loadu_si256((const __m256i*)(below + k));
+		const __m256i b1 = _mm256_loadu_si256((const __m256i*)(below + k + 1));
+		const __m256i uniform = _mm256_and_si256(
+			_mm256_and_si256(_mm256_cmpeq_epi8(a0, a1), _mm256_cmpeq_epi8(b0, b1)),
+			_mm256_cmpeq_epi8(a1, b1)
+		);
+
+		unsigned long mask = ~(unsigned long)(unsigned int)_mm256_movemask_epi8(uniform) & 0xFFFFFFFF;
+		unsigned long bit;
+		while (_BitScanForward(&bit, mask))
+		{
+			offsets[n++] = k + (int)bit;
+			mask &= mask - 1;
+		}
+	}
+	_mm256_zeroupper();
+	return n + _ScanWindows_SSE2(above, below, k, count, offsets + n);
 }
 
-// 3. Walking through an edge node array, discarding edge node types 0 and 15 and creating paths from the rest.
-// Walk directions (dir): 0 > ; 1 ^ ; 2 < ; 3 v 
-PathList ImageTracer::_PathScan(int* layer, const int width, const int height, const int pathomit)
+
+//*****************************************************************************
+
+// Error kernels used by fitting. Points xs/ys[k] for k in
+// [0, count) (half units) are points i0 + k of the sequence fitted, each one is compared 
+// to the line or spline at that parameter. Vector lanes do the same operations in the 
+// same order as the scalar versions, so results are identical.
+
+// Line start + v * i: Returns true if any squared distance exceeds threshold. Errorval and 
+// errorindex are updated with the first point whose distance is the largest one above errorval.
+static bool _LineErrors_Scalar(const int* xs, const int* ys, const int count, const int i0, const float sx, const float sy, const float vx, const float vy, const float threshold, float& errorval, int& errorindex)
 {
-	PathList::iterator pa;
-	int px = 0;
-	int py = 0;
-	int dir = 0;
-	bool pathfinished = true;
-	bool holepath = false;
+	bool fail = false;
+	for (int k = 0; k < count; ++k)
+	{
+		const float pl = (float)(i0 + k);
+		const float ptx = (xs[k] * 0.5f) - (sx + (vx * pl));
+		const float pty = (ys[k] * 0.5f) - (sy + (vy * pl));
+		const float dist2 = (ptx * ptx) + (pty * pty);
 
-	PathList paths;
+		if (dist2 > threshold) { fail = true; }
+		if (dist2 > errorval) { errorindex = i0 + k; errorval = dist2; }
+	}
+	return fail;
+}
 
-	#define L(row,col) layer[INDEX(row,col,width)]
-	for (int j = 0; j < height; j++)
+static bool _LineErrors_SSE2(const int* xs, const int* ys, const int count, const int i0, const float sx, const float sy, const float vx, const float vy, const float threshold, float& errorval, int& errorindex)
+{
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 vsx = _mm_set1_ps(sx), vsy = _mm_set1_ps(sy);
+	const __m128 vvx = _mm_set1_ps(vx), vvy = _mm_set1_ps(vy);
+	const __m128 vthreshold = _mm_set1_ps(threshold);
+
+	// Each lane keeps the first of its points with the largest distance above errorval, -1 if none
+	__m128i index = _mm_add_epi32(_mm_set1_epi32(i0), _mm_setr_epi32(0, 1, 2, 3));
+	__m128  maxval = _mm_set1_ps(errorval);
+	__m128i maxindex = _mm_set1_epi32(-1);
+	__m128  fail = _mm_setzero_ps();
+
+	int k = 0;
+	for (; k + 4 <= count; k += 4)
 	{
-		for (int i = 0; i < width; i++)
-		{
-			if ((L(j, i) == 4) || (L(j, i) == 11))
-			{ // Other values are not valid
+		const __m128 pl = _mm_cvtepi32_ps(index);
+		const __m128 px = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(xs + k))), half);
+		const __m128 py = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(ys + k))), half);
+		const __m128 ptx = _mm_sub_ps(px, _mm_add_ps(vsx, _mm_mul_ps(vvx, pl)));
+		const __m128 pty = _mm_sub_ps(py, _mm_add_ps(vsy, _mm_mul_ps(vvy, pl)));
+		const __m128 dist2 = _mm_add_ps(_mm_mul_ps(ptx, ptx), _mm_mul_ps(pty, pty));
 
-				// Init
-				px = i;
-				py = j;
-				pa = paths.insert(paths.end(), Path());
-				pa->boundingbox = BBox(px, py, px, py);
-				pathfinished = false;
-				holepath = (L(j, i) == 11);
-				dir = 1;
+		fail = _mm_or_ps(fail, _mm_cmpgt_ps(dist2, vthreshold));
 
-				// Path points loop
-				while (!pathfinished)
-				{
-					// New path point
-					pa->points.push_back(Point((float)(px - 1), (float)(py - 1)));
-					pa->linesegments.push_back(-1);
-
-					// Bounding box
-					if ((px - 1) < pa->boundingbox.coords[0]) { pa->boundingbox.coords[0] = px - 1; }
-					if ((px - 1) > pa->boundingbox.coords[2]) { pa->boundingbox.coords[2] = px - 1; }
-					if ((py - 1) < pa->boundingbox.coords[1]) { pa->boundingbox.coords[1] = py - 1; }
-					if ((py - 1) > pa->boundingbox.coords[3]) { pa->boundingbox.coords[3] = py - 1; }
-
-					// Next: look up the replacement, direction and coordinate changes = clear this cell, turn if required, walk forward
-					const int *lookuprow = _pathscan_combined_lookup[L(py, px)][dir];
-					L(py, px) = lookuprow[0];
-					dir = lookuprow[1];
-					px += lookuprow[2];
-					py += lookuprow[3];
-
-					// Close path
-					if ((px - 1 == pa->points[0].x) && (py - 1 == pa->points[0].y))
-					{
-						pathfinished = true;
+		const __m128 greater = _mm_cmpgt_ps(dist2, maxval);
+		maxval = _mm_or_ps(_mm_and_ps(greater, dist2), _mm_andnot_ps(greater, maxval));
+		maxindex = _mm_or_si128(_mm_and_si128(_mm_castps_si128(greater), index), _mm_andnot_si128(_mm_castps_si128(greater), maxindex));
 
-						// Discarding paths shorter than pathomit
-						if (pa->points.size() < pathomit)
-						{
-							paths.pop_back();
-						}
-						else
-						{
-							pa->isholepath = holepath ? true : false;
-
-							// Finding the parent shape for this hole
-							if (holepath)
-							{
-								PathList::iterator parentidx = paths.begin();
-								BBox parentbbox(-1, -1, width + 1, height + 1);
-								for (PathList::iterator parent = paths.begin(); parent != pa; parent++)
-								{
-									if ((!parent->isholepath) &&
-										parent->boundingbox.Includes(pa->boundingbox) &&
-										parentbbox.Includes(pa->boundingbox)
-									)
-									{
-										parentidx = parent;
-										parentbbox = parent->boundingbox;
-									}
-								}
-
-								//TODO: parentidx->holechildren.push(paths.distance(begin(), pa));
-
-							}// End of holepath parent finding
-						}
+		index = _mm_add_epi32(index, _mm_set1_epi32(4));
+	}
 
-					}// End of Close path
+	// Largest distance of all lanes, first point among lanes having it
+	float vals[4];
+	int indices[4];
+	_mm_storeu_ps(vals, maxval);
+	_mm_storeu_si128((__m128i*)indices, maxindex);
+	int best = -1;
+	for (int l = 0; l < 4; ++l)
+	{
+		if ((indices[l] >= 0) && ((best < 0) || (vals[l] > vals[best]) || ((vals[l] == vals[best]) && (indices[l] < indices[best]))))
+			best = l;
+	}
+	if (best >= 0)
+	{
+		errorval = vals[best];
+		errorindex = indices[best];
+	}
 
-				}// End of Path points loop
+	const bool tailfail = _LineErrors_Scalar(xs + k, ys + k, count - k, i0 + k, sx, sy, vx, vy, threshold, errorval, errorindex);
+	return (_mm_movemask_ps(fail) != 0) || tailfail;
+}
 
-			}// End of Follow path
+// Spline through start, control point c and end at i / tl: Returns true if any squared 
+// distance exceeds threshold.
+static bool _SplineErrors_Scalar(const int* xs, const int* ys, const int count, const int i0, const float tl, const float sx, const float sy, const float cx, const float cy, const float ex, const float ey, const float threshold)
+{
+	for (int k = 0; k < count; ++k)
+	{
+		const float t = (float)(i0 + k) / tl;
+		const float t1 = (1 - t) * (1 - t);
+		const float t2 = 2 * (1 - t) * t;
+		const float t3 = t * t;
 
-		}// End of i loop
-	}// End of j loop
+		const float ptx = (xs[k] * 0.5f) - ((sx * t1) + (cx * t2) + (ex * t3));
+		const float pty = (ys[k] * 0.5f) - ((sy * t1) + (cy * t2) + (ey * t3));
+		const float dist2 = (ptx * ptx) + (pty * pty);
 
-	return paths;
+		if (dist2 > threshold)
+			return true;
+	}
+	return false;
 }
 
-// 4. interpollating between path points for nodes with 8 directions ( East, SouthEast, S, SW, W, NW, N, NE )
-PathList ImageTracer::_InterNodes(const PathList& paths, const Options& options)
+static bool _SplineErrors_SSE2(const int* xs, const int* ys, const int count, const int i0, const float tl, const float sx, const float sy, const float cx, const float cy, const float ex, const float ey, const float threshold)
 {
-	PathList ins;
-
-	// paths loop
-	for (PathList::const_iterator pa = paths.begin(); pa != paths.end(); pa++)
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+	const __m128 vtl = _mm_set1_ps(tl);
+	const __m128 vsx = _mm_set1_ps(sx), vsy = _mm_set1_ps(sy);
+	const __m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy);
+	const __m128 vex = _mm_set1_ps(ex), vey = _mm_set1_ps(ey);
+	const __m128 vthreshold = _mm_set1_ps(threshold);
+
+	__m128i index = _mm_add_epi32(_mm_set1_epi32(i0), _mm_setr_epi32(0, 1, 2, 3));
+
+	int k = 0;
+	for (; k + 4 <= count; k += 4)
 	{
-		PathList::iterator n = ins.insert(ins.end(), Path());
-		n->boundingbox  = pa->boundingbox;
-		//TODO: n->holechildren = std::stack<int>(pa->holechildren);
-		n->isholepath   = pa->isholepath;
-		int palen = (int)pa->points.size();
-
-		// pathpoints loop
-		for (int pcnt = 0; pcnt < palen; pcnt++)
-		{
-			// next and previous point indexes
-			int nextidx  = (pcnt + 1) % palen;
-			int nextidx2 = (pcnt + 2) % palen;
-			int previdx  = (pcnt - 1 + palen) % palen;
-			int previdx2 = (pcnt - 2 + palen) % palen;
+		const __m128 t = _mm_div_ps(_mm_cvtepi32_ps(index), vtl);
+		const __m128 u = _mm_sub_ps(one, t);
+		const __m128 t1 = _mm_mul_ps(u, u);
+		const __m128 t2 = _mm_mul_ps(_mm_mul_ps(two, u), t);
+		const __m128 t3 = _mm_mul_ps(t, t);
+
+		const __m128 px = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(xs + k))), half);
+		const __m128 py = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(ys + k))), half);
+		const __m128 ptx = _mm_sub_ps(px, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vsx, t1), _mm_mul_ps(vcx, t2)), _mm_mul_ps(vex, t3)));
+		const __m128 pty = _mm_sub_ps(py, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vsy, t1), _mm_mul_ps(vcy, t2)), _mm_mul_ps(vey, t3)));
+		const __m128 dist2 = _mm_add_ps(_mm_mul_ps(ptx, ptx), _mm_mul_ps(pty, pty));
+
+		if (_mm_movemask_ps(_mm_cmpgt_ps(dist2, vthreshold)) != 0)
+			return true;
+
+		index = _mm_add_epi32(index, _mm_set1_epi32(4));
+	}
+	return _SplineErrors_Scalar(xs + k, ys + k, count - k, i0 + k, tl, sx, sy, cx, cy, ex, ey, threshold);
+}
 
-			Point pt = (pa->points[pcnt] + pa->points[nextidx]) / 2;
 
-			// right angle enhance
-			if (options.rightangleenhance && _TestRightAngle(*pa, previdx2, previdx, pcnt, nextidx, nextidx2))
-			{
-				// Fix previous direction
-				if (n->points.size() > 0)
-				{
-					n->linesegments.back() = _GetDirection(
-						n->points.back(),
-						pa->points[pcnt]
-					);
-				}
+//*****************************************************************************
 
-				// This corner point
-				n->points.push_back(pa->points[pcnt]);
-				n->linesegments.push_back(_GetDirection(
-					pa->points[pcnt],
-					pt
-				));
+/*static*/ bool Kernels::Supported(const KernelSet set)
+{
+	if (set == KernelSet_Scalar)
+		return true;
 
-			}// End of right angle enhance
+	int info[4];
+	__cpuid(info, 0);
+	const int max_leaf = info[0];
 
-			// interpolate between two path points
-			n->points.push_back(pt);
-			n->linesegments.push_back(_GetDirection(
-				pt,
-				((pa->points[nextidx] + pa->points[nextidx2]) / 2)
-			));
+	__cpuid(info, 1);
+	if (set == KernelSet_SSE2)
+		return (info[3] & (1 << 26)) != 0;
 
-		}// End of pathpoints loop
-						
-	}// End of paths loop
-		
-	return ins;
+	const bool avx = ((info[2] & (1 << 27)) != 0)  // OSXSAVE
+				  && ((info[2] & (1 << 28)) != 0)  // AVX
+				  && ((_xgetbv(0) & 6) == 6);      // XMM and YMM state enabled by OS
+	if ((set != KernelSet_AVX2) || !avx || (max_leaf < 7))
+		return false;
 
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
 }
 
-bool ImageTracer::_TestRightAngle(const Path& path, const int idx1, const int idx2, const int idx3, const int idx4, const int idx5) const
+/*static*/ KernelSet Kernels::Best()
 {
-	return (((path.points[idx3].x == path.points[idx1].x) &&
-			 (path.points[idx3].x == path.points[idx2].x) &&
-			 (path.points[idx3].y == path.points[idx4].y) &&
-			 (path.points[idx3].y == path.points[idx5].y)
-			) ||
-			((path.points[idx3].y == path.points[idx1].y) &&
-			 (path.points[idx3].y == path.points[idx2].y) &&
-			 (path.points[idx3].x == path.points[idx4].x) &&
-			 (path.points[idx3].x == path.points[idx5].x)
-			)
-	);
+	if (Supported(KernelSet_AVX2))
+		return KernelSet_AVX2;
+	if (Supported(KernelSet_SSE2))
+		return KernelSet_SSE2;
+	return KernelSet_Scalar;
 }
 
-template <typename T> __forceinline int sign(const T val1, const T val2) {
-    return (val1 < val2) - (val2 < val1);
+/*static*/ Kernels::ScanWindowsFunc Kernels::ScanWindows(const KernelSet set)
+{
+	if (set >= KernelSet_AVX2)
+		return _ScanWindows_AVX2;
+	if (set >= KernelSet_SSE2)
+		return _ScanWindows_SSE2;
+	return _ScanWindows_Scalar;
 }
 
-int ImageTracer::_GetDirection(const Point& pt1, const Point& pt2) const
+/*static*/ Kernels::LineErrorsFunc Kernels::LineErrors(const KernelSet set)
 {
-	const int sx = sign(pt1.x, pt2.x) + 1;
-	const int sy = sign(pt1.y, pt2.y) + 1;
+	return (set >= KernelSet_SSE2) ? _LineErrors_SSE2 : _LineErrors_Scalar;
+}
+
+/*static*/ Kernels::SplineErrorsFunc Kernels::SplineErrors(const KernelSet set)
+{
+	return (set >= KernelSet_SSE2) ? _SplineErrors_SSE2 : _SplineErrors_Scalar;
+}
+
+
+//*****************************************************************************
+
+BBoxGrid::BBoxGrid()
+	: _cellsize(16)
+	, _cols(0)
+	, _rows(0)
+{ }
+
+BBoxGrid::BBoxGrid(const BBox& area)
+{
+	Reset(area);
+}
+
+void BBoxGrid::Reset(const BBox& area)
+{
+	_area = area;
+
+	// At most 64 x 64 cells, none of them smaller than 16 x 16
+	const int width = area.coords[2] - area.coords[0] + 1;
+	const int height = area.coords[3] - area.coords[1] + 1;
+	const int size = (width > height) ? width : height;
+	_cellsize = (size + 63) / 64;
+	if (_cellsize < 16)
+		_cellsize = 16;
+
+	_cols = (width + _cellsize - 1) / _cellsize;
+	_rows = (height + _cellsize - 1) / _cellsize;
+
+	// Storage beyond what's needed is kept for later areas
+	const int count = _cols * _rows;
+	_heads.assign(count, -1);
+	_tails.assign(count, -1);
+	_entries.clear();
+}
+
+void BBoxGrid::Add(const int index, const BBox& bbox)
+{
+	const int c0 = _Col(bbox.coords[0]), c1 = _Col(bbox.coords[2]);
+	const int r0 = _Row(bbox.coords[1]), r1 = _Row(bbox.coords[3]);
+	for (int r = r0; r <= r1; ++r)
+	{
+		for (int c = c0; c <= c1; ++c)
+		{
+			// Appended to cell's chain, keeping indices in order added
+			const int cell = r * _cols + c;
+			const int entry = (int)_entries.size();
+			_entries.push_back(Entry{ index, -1 });
+			if (_tails[cell] < 0)
+				_heads[cell] = entry;
+			else
+				_entries[_tails[cell]].next = entry;
+			_tails[cell] = entry;
+		}
+	}
+}
+
+BBoxGrid::CandidateList BBoxGrid::Candidates(const int x, const int y) const
+{
+	return CandidateList(_entries, _heads[_Row(y) * _cols + _Col(x)]);
+}
+
+int BBoxGrid::_Col(const int x) const
+{
+	const int c = (x - _area.coords[0]) / _cellsize;
+	return (c < 0) ? 0 : (c >= _cols) ? _cols - 1 : c;
+}
+
+int BBoxGrid::_Row(const int y) const
+{
+	const int r = (y - _area.coords[1]) / _cellsize;
+	return (r < 0) ? 0 : (r >= _rows) ? _rows - 1 : r;
+}
+
+
+BBoxGrid::CandidateList::CandidateList(const std::vector<Entry>& entries, const int first)
+	: _entries(entries)
+	, _first(first)
+{ }
+
+BBoxGrid::CandidateList::const_iterator BBoxGrid::CandidateList::begin() const
+{
+	return const_iterator(_entries, _first);
+}
+
+BBoxGrid::CandidateList::const_iterator BBoxGrid::CandidateList::end() const
+{
+	return const_iterator(_entries, -1);
+}
+
+BBoxGrid::CandidateList::const_iterator::const_iterator(const std::vector<Entry>& entries, const int entry)
+	: _entries(&entries)
+	, _entry(entry)
+{ }
+
+int BBoxGrid::CandidateList::const_iterator::operator*() const
+{
+	return (*_entries)[_entry].index;
+}
+
+bool BBoxGrid::CandidateList::const_iterator::operator!=(const const_iterator& other) const
+{
+	return _entry != other._entry;
+}
+
+BBoxGrid::CandidateList::const_iterator& BBoxGrid::CandidateList::const_iterator::operator++()
+{
+	_entry = (*_entries)[_entry].next;
+	return *this;
+}
+
+
+//*****************************************************************************
+
+Cell::Cell()
+{ }
+
+Cell::Cell(const int _x, const int _y)
+	: x(_x)
+	, y(_y)
+{ }
+
+bool Cell::operator<(const Cell& cell) const
+{
+	return (y < cell.y) || ((y == cell.y) && (x < cell.x));
+}
+
+
+//*****************************************************************************
+
+PathFragment::PathFragment()
+	: first(0)
+	, firsttype(0)
+{
+	ends[0] = ends[1] = -1;
+}
+
+bool PathFragment::IsClosed() const
+{
+	return (ends[0] < 0);
+}
+
+
+//*****************************************************************************
+
+bool PathStitcher::Add(PathFragment&& fragment, PathFragment& closed)
+{
+	const long long crossings[2] = { fragment.ends[0], fragment.ends[1] };
+
+	int f;
+	if (_freefragments.empty())
+	{
+		f = (int)_fragments.size();
+		_fragments.push_back(std::move(fragment));
+	}
+	else
+	{
+		f = _freefragments.back();
+		_freefragments.pop_back();
+		_fragments[f] = std::move(fragment);
+	}
+
+	// New chain consisting of this fragment only
+	int c;
+	if (_freechains.empty())
+	{
+		c = (int)_chains.size();
+		_chains.push_back(Chain());
+	}
+	else
+	{
+		c = _freechains.back();
+		_freechains.pop_back();
+	}
+	_chains[c].parts.push_back(f * 2);
+	_chains[c].ends[0] = crossings[0];
+	_chains[c].ends[1] = crossings[1];
+
+	// Join with chains already waiting at either crossing
+	bool joined[2] = { false, false };
+	for (int e = 0; e < 2; ++e)
+	{
+		auto it = _open.find(crossings[e]);
+		if (it == _open.end())
+			continue;
+
+		const int other = it->second;
+		_open.erase(it);
+		joined[e] = true;
+		if (other == c)
+		{
+			// Both ends of this chain meet
+			_Close(c, closed);
+			return true;
+		}
+
+		c = _Join(other, c, crossings[e]);
+	}
+
+	// Waiting for the counterparts of remaining crossings
+	for (int e = 0; e < 2; ++e)
+	{
+		if (!joined[e])
+			_open[crossings[e]] = c;
+	}
+
+	return false;
+}
+
+int PathStitcher::Pending() const
+{
+	return (int)(_fragments.size() - _freefragments.size());
+}
+
+void PathStitcher::Chain::Reverse()
+{
+	std::reverse(parts.begin(), parts.end());
+	for (auto& p : parts)
+		p ^= 1;
+	std::swap(ends[0], ends[1]);
+}
+
+int PathStitcher::_Join(const int chain1, const int chain2, const long long crossing)
+{
+	// Smaller chain gets joined into the larger one
+	int c1 = chain1, c2 = chain2;
+	if (_chains[c1].parts.size() < _chains[c2].parts.size())
+		std::swap(c1, c2);
+	Chain& large = _chains[c1];
+	Chain& small = _chains[c2];
+
+	if (large.ends[1] == crossing)
+	{
+		// Append, small chain has to start with crossing
+		if (small.ends[0] != crossing)
+			small.Reverse();
+		large.parts.insert(large.parts.end(), small.parts.begin(), small.parts.end());
+		large.ends[1] = small.ends[1];
+	}
+	else
+	{
+		// Prepend, small chain has to end with crossing
+		if (small.ends[1] != crossing)
+			small.Reverse();
+		large.parts.insert(large.parts.begin(), small.parts.begin(), small.parts.end());
+		large.ends[0] = small.ends[0];
+	}
+
+	small.parts.clear();
+	_freechains.push_back(c2);
+
+	// Small chain's other end is now waiting as part of the large one
+	for (int e = 0; e < 2; ++e)
+	{
+		auto it = _open.find(large.ends[e]);
+		if ((it != _open.end()) && (it->second == c2))
+			it->second = c1;
+	}
+
+	return c1;
+}
+
+void PathStitcher::_Close(const int chain, PathFragment& closed)
+{
+	Chain& ch = _chains[chain];
+
+	// Concat all fragments and find first cell in raster order
+	closed = PathFragment();
+	int q = -1;
+	for (auto p : ch.parts)
+	{
+		PathFragment& frag = _fragments[p / 2];
+		const int offset = (int)closed.cells.size();
+		const int size = (int)frag.cells.size();
+		const bool reversed = (p & 1) != 0;
+
+		if (reversed)
+			closed.cells.insert(closed.cells.end(), frag.cells.rbegin(), frag.cells.rend());
+		else
+			closed.cells.insert(closed.cells.end(), frag.cells.begin(), frag.cells.end());
+
+		const int pos = offset + (reversed ? size - 1 - frag.first : frag.first);
+		if ((q < 0) || (closed.cells[pos] < closed.cells[q]))
+		{
+			q = pos;
+			closed.firsttype = frag.firsttype;
+		}
+
+		// Release fragment
+		CellList().swap(frag.cells);
+		_freefragments.push_back(p / 2);
+	}
+
+	ch.parts.clear();
+	_freechains.push_back(chain);
+
+	// Contours start at their first cell walking right, which is the direction
+	// pathscan would have taken. Otherwise direction has to be reversed.
+	const int count = (int)closed.cells.size();
+	const Cell start = closed.cells[q];
+	const Cell& next = closed.cells[(q + 1) % count];
+	if ((next.x == start.x + 1) && (next.y == start.y))
+	{
+		std::rotate(closed.cells.begin(), closed.cells.begin() + q, closed.cells.end());
+	}
+	else
+	{
+		std::reverse(closed.cells.begin(), closed.cells.end());
+		std::rotate(closed.cells.begin(), closed.cells.begin() + (count - 1 - q), closed.cells.end());
+	}
+}
+
+
+//*****************************************************************************
+
+BatchImage::BatchImage()
+	: Pixels(nullptr)
+	, Width(0)
+	, Height(0)
+{ }
+
+BatchImage::BatchImage(byte* pixels, const int width, const int height)
+	: Pixels(pixels)
+	, Width(width)
+	, Height(height)
+{ }
+
+
+//*****************************************************************************
+
+TraceStats::TraceStats()
+	: Threads(0)
+	, LoadBalance(0)
+	, ParallelPaths(false)
+	, LayersReused(0)
+	, PolysReused(0)
+{ }
+
+
+//*****************************************************************************
+
+#define INDEX(row,col,width) (((row)*width)+(col))
+
+// OpenMP helpers, working w/o OpenMP too
+static int _MaxThreads()
+{
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+static int _ThreadNum()
+{
+#ifdef _OPENMP
+	return omp_get_thread_num();
+#else
+	return 0;
+#endif
+}
+
+static int _TeamSize()
+{
+#ifdef _OPENMP
+	return omp_get_num_threads();
+#else
+	return 1;
+#endif
+}
+
+static double _Now()
+{
+#ifdef _OPENMP
+	return omp_get_wtime();
+#else
+	return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+// Lists color indices found in histogram in ascending order, returns their number.
+// Throws if there's nothing to trace or reserved color index 255 is used.
+static int _FoundColors(const int* histogram, int* colors)
+{
+	byte min = 255, max = 0;
+	for (int c = 0; c < 256; ++c)
+	{
+		if (histogram[c])
+		{
+			if (c < min)
+				min = c;
+			max = c;
+		}
+	}
+	if (min >= max)
+		throw new TraceException("Can't trace empty image");
+	if (max == 255)
+		throw new TraceException("Color index 255 is reserved, please adjust your input");
+
+	int color_count = 0;
+	for (int c = min; c <= max; ++c)
+	{
+		if (histogram[c])
+			colors[color_count++] = c;
+	}
+	return color_count;
+}
+
+// Deals items sorted by estimated cost, most expensive first, to threads: Each one goes to
+// the thread with least cost dealt so far, lowest one on ties. Same costs are always dealt 
+// same way. Stores thread of each item to owners, load is scratch space.
+static void _Deal(const size_t* costs, const int count, const int threads, int* owners, std::vector<size_t>& load)
+{
+	load.assign(threads, 0);
+	for (int i = 0; i < count; ++i)
+	{
+		const int t = (int)(std::min_element(load.begin(), load.end()) - load.begin());
+		owners[i] = t;
+		load[t] += costs[i];
+	}
+}
+
+// Load balance: Total busy time vs. all threads being busy as long as the longest one,
+// 1 = perfectly balanced (also if nothing was done at all)
+static double _LoadBalance(const std::vector<double>& busy)
+{
+	double busy_total = 0, busy_max = 0;
+	for (auto b : busy)
+	{
+		busy_total += b;
+		if (b > busy_max)
+			busy_max = b;
+	}
+	return (busy_max > 0) ? busy_total / (busy_max * busy.size()) : 1.0;
+}
+
+// Appends layers of part to flat, offsets of part being relative to its own start
+static void _AppendFlat(const FlatResult& part, FlatResult& flat)
+{
+	const int poly_base = (int)flat.PolyHoles.size();
+	const int segment_base = (int)flat.Segments.size();
+	const int child_base = (int)flat.HoleChildren.size();
+
+	flat.LayerColors.insert(flat.LayerColors.end(), part.LayerColors.begin(), part.LayerColors.end());
+	for (size_t i = 1; i < part.LayerOffsets.size(); ++i)
+		flat.LayerOffsets.push_back(poly_base + part.LayerOffsets[i]);
+	for (size_t i = 1; i < part.PolyOffsets.size(); ++i)
+		flat.PolyOffsets.push_back(segment_base + part.PolyOffsets[i]);
+	for (size_t i = 1; i < part.HoleOffsets.size(); ++i)
+		flat.HoleOffsets.push_back(child_base + part.HoleOffsets[i]);
+	flat.PolyHoles.insert(flat.PolyHoles.end(), part.PolyHoles.begin(), part.PolyHoles.end());
+	flat.PolyBBoxes.insert(flat.PolyBBoxes.end(), part.PolyBBoxes.begin(), part.PolyBBoxes.end());
+	flat.HoleChildren.insert(flat.HoleChildren.end(), part.HoleChildren.begin(), part.HoleChildren.end());
+	flat.Segments.Concat(part.Segments);
+}
+
+// Discarding paths shorter than pathomit
+static bool _Omitted(const int points, const int pathomit)
+{
+	return points < pathomit;
+}
+
+// Polygon taking over segments and hole children of path traced
+static Poly _ToPoly(Path& path)
+{
+	return Poly(std::move(path.segments), path.boundingbox, path.isholepath, std::move(path.holechildren), path.startx, path.starty);
+}
+
+// Appends polygons of all paths traced to polys, hole children are same indices within 
+// polys as within paths
+static void _AppendPolys(PathList& paths, PolyList& polys)
+{
+	polys.reserve(polys.size() + paths.size());
+	for (auto& p : paths)
+		polys.push_back(_ToPoly(p));
+}
+
+// Whether both bounding boxes share at least one cell
+static bool _Overlaps(const BBox& a, const BBox& b)
+{
+	return (a.coords[0] <= b.coords[2]) && (b.coords[0] <= a.coords[2]) && 
+		(a.coords[1] <= b.coords[3]) && (b.coords[1] <= a.coords[3]);
+}
+
+// Traces color-indexed image data
+ImageTracer* ImageTracer::Trace(byte* pixels, const int width, const int height, const Options& options)
+{
+	ImageTracer* trc = nullptr;
+	try
+	{
+		trc = new ImageTracer();
+		if (trc)
+		{
+			trc->_Trace(pixels, width, height, options);
+			trc->_Release();
+		}
+	}
+	catch (...)
+	{
+		if (trc)
+			delete trc;
+		trc = nullptr;
+	}
+	return trc;
+}
+
+// Layers are written to flat arrays while being traced, w/o any nested lists in between
+FlatResult* ImageTracer::TraceFlat(byte* pixels, const int width, const int height, const Options& options)
+{
+	FlatResult* flat = nullptr;
+	try
+	{
+		ImageTracer trc;
+		flat = new FlatResult();
+		trc._Trace(pixels, width, height, options, flat);
+	}
+	catch (...)
+	{
+		if (flat)
+			delete flat;
+		flat = nullptr;
+	}
+	return flat;
+}
+
+bool ImageTracer::TraceStream(const int width, const RowSource& source, const PolySink& sink, const Options& options, const int bandrows)
+{
+	try
+	{
+		ImageTracer trc;
+		trc._TraceStream(width, source, sink, options, bandrows);
+	}
+	catch (...)
+	{
+		return false;
+	}
+	return true;
+}
+
+ImageTracer* ImageTracer::Retrace(const ImageTracer& previous, byte* pixels, const int width, const int height, const BBox& dirty, const Options& options)
+{
+	ImageTracer* trc = nullptr;
+	try
+	{
+		trc = new ImageTracer();
+		if (trc)
+		{
+			trc->Layers = previous.Layers;
+			trc->_Retrace(pixels, width, height, dirty, options);
+			trc->_Release();
+		}
+	}
+	catch (...)
+	{
+		if (trc)
+			delete trc;
+		trc = nullptr;
+	}
+	return trc;
+}
+
+std::vector<ImageTracer*> ImageTracer::TraceBatch(const BatchImageList& images, const Options& options)
+{
+	const int count = (int)images.size();
+	std::vector<ImageTracer*> results(count, nullptr);
+	std::vector<char> failed(count, 0);
+
+	// Scratch memory shared by all images, one arena, grid and pool per thread.
+	// Edge nodes are kept by each image's result until its layers are traced.
+	ImageTracer worker;
+	worker._arenas.resize(_MaxThreads());
+	worker._grids.resize(_MaxThreads());
+	worker._fitted.resize(_MaxThreads());
+	std::vector<PolyPool> pools(_MaxThreads());
+	std::vector<BBox> colorbboxes((size_t)count * 256);
+
+	// 1. Layering, one image per thread
+#pragma omp parallel for schedule(dynamic, 4) shared(images, count, results, failed, worker, colorbboxes)
+	for (int i = 0; i < count; ++i)
+	{
+		try
+		{
+			results[i] = new ImageTracer();
+			ImageTracer& trc = *results[i];
+			trc._edgenodes.resize(256);
+
+			int histogram[256] = { 0 };
+			worker._LayeringStep(images[i].Pixels, images[i].Width, images[i].Height, trc._edgenodes.data(), histogram, &colorbboxes[(size_t)i * 256]);
+
+			int colors[256];
+			const int color_count = _FoundColors(histogram, colors);
+			trc.Layers.resize(color_count);
+			for (int s = 0; s < color_count; ++s)
+				trc.Layers[s].ColorIndex = colors[s];
+		}
+		catch (...)
+		{
+			failed[i] = 1;
+		}
+	}
+
+	// 2. Layers of all images as one list of work items, most expensive first as
+	// estimated by their edge nodes. Ties stay in input order.
+	class WorkItem
+	{
+	public:
+		int    image;
+		int    slot;
+		size_t cost;
+	};
+	std::vector<WorkItem> items;
+	for (int i = 0; i < count; ++i)
+	{
+		if (failed[i])
+			continue;
+		for (int s = 0; s < (int)results[i]->Layers.size(); ++s)
+		{
+			WorkItem item;
+			item.image = i;
+			item.slot = s;
+			item.cost = results[i]->_edgenodes[results[i]->Layers[s].ColorIndex].size();
+			items.push_back(item);
+		}
+	}
+	std::stable_sort(items.begin(), items.end(), [](const WorkItem& a, const WorkItem& b) {
+		return a.cost > b.cost;
+	});
+
+	std::vector<double> busy(_MaxThreads(), 0.0);
+	const int item_count = (int)items.size();
+
+	// Failures are kept per item, as other threads might be tracing layers of same image.
+	// Those are merged per image once all items are done.
+	std::vector<char> itemfailed(item_count, 0);
+
+#pragma omp parallel for schedule(dynamic, 1) shared(images, options, results, worker, pools, colorbboxes, items, item_count, itemfailed, busy)
+	for (int n = 0; n < item_count; ++n)
+	{
+		const double start = _Now();
+		const int i = items[n].image;
+		try
+		{
+			Layer& layer = results[i]->Layers[items[n].slot];
+			layer.Polygons = worker._TraceLayer(
+				results[i]->_edgenodes[layer.ColorIndex],
+				colorbboxes[(size_t)i * 256 + layer.ColorIndex],
+				images[i].Width,
+				images[i].Height,
+				options,
+				false,
+				pools[_ThreadNum()]
+			);
+		}
+		catch (...)
+		{
+			itemfailed[n] = 1;
+		}
+
+		// Nothing allocated from arenas outlives a layer
+		worker._Arena().Rewind(0);
+		busy[_ThreadNum()] += _Now() - start;
+	}
+
+	for (int n = 0; n < item_count; ++n)
+	{
+		if (itemfailed[n])
+			failed[items[n].image] = 1;
+	}
+
+	const double balance = _LoadBalance(busy);
+	for (int i = 0; i < count; ++i)
+	{
+		if (failed[i])
+		{
+			delete results[i];
+			results[i] = nullptr;
+			continue;
+		}
+
+		// Statistics are those of the whole batch
+		results[i]->_Release();
+		results[i]->Stats.Threads = (int)busy.size();
+		results[i]->Stats.ParallelPaths = false;
+		results[i]->Stats.LoadBalance = balance;
+	}
+
+	return results;
+}
+
+ImageTracer::ImageTracer()
+{ }
+
+Arena& ImageTracer::_Arena()
+{
+	return _arenas[_ThreadNum()];
+}
+
+BBoxGrid& ImageTracer::_Grid()
+{
+	return _grids[_ThreadNum()];
+}
+
+SegmentList& ImageTracer::_Fitted()
+{
+	return _fitted[_ThreadNum()];
+}
+
+void ImageTracer::_Release()
+{
+	std::vector<Arena>().swap(_arenas);
+	std::vector<BBoxGrid>().swap(_grids);
+	std::vector<SegmentList>().swap(_fitted);
+	std::vector<PolyPool>().swap(_pools);
+	std::vector<EdgeNodeList>().swap(_edgenodes);
+	std::vector<double>().swap(_busy);
+	std::vector<size_t>().swap(_load);
+	std::vector< std::pair<int, int> >().swap(_sequences);
+	std::vector<SegmentList>().swap(_seqsegments);
+}
+
+void ImageTracer::_ReservePools()
+{
+	_pools.resize(256);
+	for (auto& layer : Layers)
+		_pools[layer.ColorIndex].Reserve(layer.Polygons.size());
+}
+
+void ImageTracer::_Trace(byte* pixels, const int width, const int height, const Options& options, FlatResult* flat)
+{
+	// Single pass layering, collecting edge nodes for all colors at once as well as
+	// histogram and bounding boxes per color index.
+	// Image is read in place with a virtual 1px border around it, border uses color index 255.
+	// Scratch memory is set up first, being kept from previous calls if any.
+	_arenas.resize(_MaxThreads());
+	_grids.resize(_MaxThreads());
+	_fitted.resize(_MaxThreads());
+	_edgenodes.resize(256);
+	for (auto& nodes : _edgenodes)
+		nodes.clear();
+
+	std::vector<EdgeNodeList>& edgenodes = _edgenodes;
+	int histogram[256] = { 0 };
+	BBox colorbboxes[256];
+	_LayeringStep(pixels, width, height, edgenodes.data(), histogram, colorbboxes);
+
+	// Schedule all color indices found by their estimated cost, most expensive first.
+	// Every edge node ends up as path point to be interpolated and fitted, so their
+	// number is a good estimate.
+	// Layers are pre-allocated with one slot per color index found, in ascending
+	// order, so each thread can store its result w/o locking and with a stable order.
+	int colors[256];
+	int slots[256];
+	const int color_count = _FoundColors(histogram, colors);
+	for (int s = 0; s < color_count; ++s)
+		slots[colors[s]] = s;
+	// Ties stay in ascending order
+	std::sort(colors, colors + color_count, [&edgenodes](const int a, const int b) {
+		return (edgenodes[a].size() > edgenodes[b].size()) || 
+			((edgenodes[a].size() == edgenodes[b].size()) && (a < b));
+	});
+
+	// Storage of previous results gets reused for new ones of same color index
+	_pools.resize(256);
+	for (auto& layer : Layers)
+		_pools[layer.ColorIndex].Give(layer.Polygons);
+	Layers.clear();
+	Layers.resize(color_count);
+
+	// Busy time per thread, for load balance statistics
+	std::vector<double>& busy = _busy;
+	busy.assign(_MaxThreads(), 0.0);
+
+	// Too few colors to keep all threads busy: Trace layers one after another and 
+	// have their paths traced in parallel instead. Only one of both levels runs in 
+	// parallel, so threads are never oversubscribed.
+	const bool parallel_paths = (color_count < _MaxThreads());
+
+	// Layers traced one after another go in ascending order, same as slots, so flat results 
+	// get them appended right away. Those traced in parallel are written to a part of their 
+	// own first, one per slot.
+	const bool sequential = parallel_paths || (_MaxThreads() == 1);
+	std::vector<FlatResult> parts;
+	if (flat && !sequential)
+		parts.resize(color_count);
+
+	// Otherwise layers are dealt to threads up front instead of being taken by whichever 
+	// thread is idle, so same image always puts same layers on each thread and scratch 
+	// memory kept per thread fits them again
+	int owners[256];
+	if (!sequential)
+	{
+		size_t costs[256];
+		for (int c = 0; c < color_count; ++c)
+			costs[c] = edgenodes[colors[c]].size();
+		_Deal(costs, color_count, _MaxThreads(), owners, _load);
+	}
+
+	auto trace = [&](const int color_index)
+	{
+		const double start = _Now();
+
+		if (flat)
+		{
+			FlatResult& part = sequential ? *flat : parts[slots[color_index]];
+			_TraceLayer(edgenodes[color_index], colorbboxes[color_index], width, height, options, parallel_paths, _pools[color_index], color_index, part);
+		}
+		else
+		{
+			Layer& slot = Layers[slots[color_index]];
+			slot.Polygons = _TraceLayer(edgenodes[color_index], colorbboxes[color_index], width, height, options, parallel_paths, _pools[color_index]);
+			slot.ColorIndex = color_index;
+		}
+
+		// Nothing allocated from arenas outlives a layer
+		if (parallel_paths)
+		{
+			for (auto& arena : _arenas)
+				arena.Rewind(0);
+		}
+		else
+			_Arena().Rewind(0);
+
+		busy[_ThreadNum()] += _Now() - start;
+	};
+
+	// Loop over all color indices found
+	if (sequential)
+	{
+		for (int i = 0; i < 256; ++i)
+		{
+			if (histogram[i] > 0)
+				trace(i);
+		}
+	}
+	else
+	{
+#pragma omp parallel shared(color_count, owners, trace)
+		{
+			// Fewer threads than dealt to share their layers
+			const int thread = _ThreadNum();
+			const int team = _TeamSize();
+			for (int c = 0; c < color_count; ++c)
+			{
+				if (owners[c] % team == thread)
+					trace(colors[c]);
+			}
+		}
+
+		for (auto& part : parts)
+			_AppendFlat(part, *flat);
+	}
+
+	// Layers traced one after another only keep a single thread busy in layer loop, 
+	// which would show as poor balance though path stages use all threads, so it's 
+	// reported as not measured
+	Stats.Threads = parallel_paths ? 1 : (int)busy.size();
+	Stats.ParallelPaths = parallel_paths;
+	Stats.LoadBalance = parallel_paths ? -1.0 : _LoadBalance(busy);
+	Stats.LayersReused = 0;
+	Stats.PolysReused = 0;
+}
+
+PolyList ImageTracer::_TraceLayer(const EdgeNodeList& edgenodes, const BBox& colorbbox, const int width, const int height, const Options& options, const bool parallel, PolyPool& pool)
+{
+	PathList paths = _TraceLayerPaths(edgenodes, colorbbox, width, height, options, parallel, pool, nullptr);
+
+	// adding traced layer
+	PolyList polys;
+	pool.Take(polys);
+	_AppendPolys(paths, polys);
+
+	return polys;
+}
+
+void ImageTracer::_TraceLayer(const EdgeNodeList& edgenodes, const BBox& colorbbox, const int width, const int height, const Options& options, const bool parallel, PolyPool& pool, const int color_index, FlatResult& flat)
+{
+	// Paths traced as soon as they're closed already have their segments in flat
+	PathList paths = _TraceLayerPaths(edgenodes, colorbbox, width, height, options, parallel, pool, &flat);
+
+	// adding traced layer, hole children are same indices within layer as within paths
+	for (auto& p : paths)
+	{
+		if (parallel)
+		{
+			flat.Segments.Concat(p.segments);
+			flat.PolyOffsets.push_back((int)flat.Segments.size());
+		}
+		flat.PolyHoles.push_back(p.isholepath ? 1 : 0);
+		flat.PolyBBoxes.insert(flat.PolyBBoxes.end(), p.boundingbox.coords, p.boundingbox.coords + 4);
+		flat.HoleChildren.insert(flat.HoleChildren.end(), p.holechildren.begin(), p.holechildren.end());
+		flat.HoleOffsets.push_back((int)flat.HoleChildren.size());
+	}
+	flat.LayerColors.push_back(color_index);
+	flat.LayerOffsets.push_back((int)flat.PolyHoles.size());
+}
+
+PathList ImageTracer::_TraceLayerPaths(const EdgeNodeList& edgenodes, const BBox& colorbbox, const int width, const int height, const Options& options, const bool parallel, PolyPool& pool, FlatResult* flat)
+{
+	// Edge node indices and layer areas are based on bordered coordinates
+	const int bordered_width = width + 2;
+	const int bordered_height = height + 2;
+
+	// Edge nodes of this color are limited to the cells touching its bounding box, 
+	// so layer only needs to cover that area
+	const BBox area(colorbbox.coords[0] + 1, colorbbox.coords[1] + 1, colorbbox.coords[2] + 2, colorbbox.coords[3] + 2);
+	const int area_width = area.coords[2] - area.coords[0] + 1;
+	const int area_height = area.coords[3] - area.coords[1] + 1;
+	const int area_length = area_width * area_height;
+
+	// edge nodes -> pathscan -> internodes -> batchtracepaths
+	byte* layer = static_cast<byte*>(_Arena().Allocate(area_length, 16));
+	memset(layer, 0, area_length);
+	for (auto n : edgenodes)
+	{
+		const int row = (n.index / bordered_width) - area.coords[1];
+		const int col = (n.index % bordered_width) - area.coords[0];
+		layer[INDEX(row, col, area_width)] = n.type;
+	}
+
+	// Large layers traced on their own get their pathscan split into stripes
+	const int stripes = 2 * _MaxThreads();
+	const bool stripescan = parallel && 
+		((int)edgenodes.size() >= _stripescan_min_nodes) && 
+		(area_height >= stripes * _stripescan_min_rows);
+
+	// Layers traced in parallel with others have each path traced as soon as pathscan closes it,
+	// otherwise stages run one after another with each of them running in parallel
+	PathList paths = stripescan ?
+		_PathScanStripes(
+			layer, 
+			edgenodes,
+			area,
+			bordered_width, 
+			bordered_height,
+			options.pathomit,
+			stripes,
+			pool
+		) :
+		_PathScan(
+			layer, 
+			edgenodes,
+			area,
+			bordered_width, 
+			bordered_height,
+			options,
+			!parallel,
+			pool,
+			flat
+		);
+	if (parallel)
+	{
+		// Segments traced join the scanned paths, which hold the hole children
+		PathList tracedpaths = _BatchTracePaths(
+			_InterNodes(
+				paths,
+				options,
+				parallel
+			),
+			options.ltres,
+			options.qtres,
+			parallel,
+			pool
+		);
+		for (int i = 0; i < (int)paths.size(); ++i)
+			paths[i].segments.swap(tracedpaths[i].segments);
+	}
+
+	return paths;
+}
+
+void ImageTracer::_Retrace(byte* pixels, const int width, const int height, const BBox& dirty, const Options& options)
+{
+	// Dirty pixels within image
+	const int l = std::max(dirty.coords[0], 0);
+	const int t = std::max(dirty.coords[1], 0);
+	const int r = std::min(dirty.coords[2], width - 1);
+	const int b = std::min(dirty.coords[3], height - 1);
+	if ((l > r) || (t > b))
+	{
+		Stats.LayersReused = (int)Layers.size();
+		Stats.PolysReused = 0;
+		for (auto& layer : Layers)
+			Stats.PolysReused += (int)layer.Polygons.size();
+		return;
+	}
+
+	_arenas.resize(_MaxThreads());
+	_grids.resize(_MaxThreads());
+	_fitted.resize(_MaxThreads());
+	_pools.resize(256);
+	_edgenodes.resize(256);
+	for (auto& nodes : _edgenodes)
+		nodes.clear();
+
+	// Each cell's edge node is made of the pixels above and left of it, so dirty pixels
+	// change cells up to one further right and down (path coordinates)
+	const BBox dirtycells(l, t, r + 1, b + 1);
+
+	int previous[256];
+	std::fill(previous, previous + 256, -1);
+	for (int i = 0; i < (int)Layers.size(); ++i)
+		previous[Layers[i].ColorIndex] = i;
+
+	bool present[256] = { false };
+	for (int y = t; y <= b; ++y)
+	{
+		for (int x = l; x <= r; ++x)
+			present[pixels[INDEX(y, x, width)]] = true;
+	}
+	if (present[255])
+		throw new TraceException("Color index 255 is reserved, please adjust your input");
+
+	// A changed contour runs through dirty cells and cells of previous contours which ran 
+	// through them, too. Those are either previous polygons or contours discarded by pathomit,
+	// which can't reach further than pathomit from dirty cells. So changed contours of each 
+	// color are within the bounding box of these, which is scanned again.
+	const int reach = std::max(options.pathomit, 1);
+	const BBox reachable(
+		std::max(dirtycells.coords[0] - reach, 0), 
+		std::max(dirtycells.coords[1] - reach, 0), 
+		std::min(dirtycells.coords[2] + reach, width), 
+		std::min(dirtycells.coords[3] + reach, height)
+	);
+	BBox areas[256];
+	bool touched[256] = { false };
+	bool untouched[256] = { false };
+	int row0 = reachable.coords[1], row1 = reachable.coords[3];
+	for (auto& layer : Layers)
+	{
+		BBox& area = areas[layer.ColorIndex];
+		area = reachable;
+		for (auto& p : layer.Polygons)
+		{
+			const BBox& bbox = p.BoundingBox;
+			if (!_Overlaps(bbox, dirtycells))
+			{
+				untouched[layer.ColorIndex] = true;
+				continue;
+			}
+
+			touched[layer.ColorIndex] = true;
+			area.coords[0] = std::max(std::min(area.coords[0], bbox.coords[0]), 0);
+			area.coords[1] = std::max(std::min(area.coords[1], bbox.coords[1]), 0);
+			area.coords[2] = std::min(std::max(area.coords[2], bbox.coords[2]), width);
+			area.coords[3] = std::min(std::max(area.coords[3], bbox.coords[3]), height);
+		}
+		row0 = std::min(row0, area.coords[1]);
+		row1 = std::max(row1, area.coords[3]);
+	}
+
+	// Layering for all of these rows, bordered row of cells being one below
+	{
+		Arena& arena = _Arena();
+		const size_t mark = arena.Mark();
+		byte* borderrow = static_cast<byte*>(arena.Allocate(width, 16));
+		int* offsets = static_cast<int*>(arena.Allocate(width * sizeof(int), 16));
+		memset(borderrow, 255, width);
+
+		for (int j = row0 + 1; j <= row1 + 1; j++)
+		{
+			const byte* above = (j > 1)       ? pixels + (j - 2) * width : borderrow;
+			const byte* below = (j <= height) ? pixels + (j - 1) * width : borderrow;
+			_LayeringRow(above, below, width, j, offsets, _edgenodes.data());
+		}
+
+		arena.Rewind(mark);
+	}
+
+	// Colors only found in previous layers might have disappeared. Any polygon left 
+	// untouched still has pixels of its color next to it, otherwise pixels outside of 
+	// dirty ones need to be checked.
+	for (int c = 0; c < 255; ++c)
+	{
+		if (present[c] || (previous[c] < 0))
+			continue;
+
+		present[c] = untouched[c];
+		for (int y = 0; (y < height) && !present[c]; ++y)
+		{
+			const byte* row = pixels + y * width;
+			if ((y < t) || (y > b))
+				present[c] = (memchr(row, c, width) != nullptr);
+			else
+				present[c] = ((l > 0) && (memchr(row, c, l) != nullptr)) || 
+					((r < width - 1) && (memchr(row + r + 1, c, width - r - 1) != nullptr));
+		}
+	}
+
+	int colors[256];
+	int color_count = 0;
+	for (int c = 0; c < 255; ++c)
+	{
+		if (present[c])
+			colors[color_count++] = c;
+	}
+	if (color_count < 2)
+		throw new TraceException("Can't trace empty image");
+
+	// Layers without any change are taken over as they are, all others get their
+	// contours touching dirty cells traced again
+	const int bordered_width = width + 2;
+	LayerList layers;
+	layers.resize(color_count);
+	int work[256];
+	int work_count = 0;
+	int kept_count[256] = { 0 };
+	Stats.LayersReused = 0;
+	Stats.PolysReused = 0;
+	for (int k = 0; k < color_count; ++k)
+	{
+		const int c = colors[k];
+		bool changed = (previous[c] < 0) || touched[c];
+		for (auto it = _edgenodes[c].begin(); !changed && (it != _edgenodes[c].end()); ++it)
+		{
+			const int x = (it->index % bordered_width) - 1;
+			const int y = (it->index / bordered_width) - 1;
+			changed = (x >= dirtycells.coords[0]) && (x <= dirtycells.coords[2]) && 
+				(y >= dirtycells.coords[1]) && (y <= dirtycells.coords[3]);
+		}
+
+		if (changed)
+		{
+			layers[k].ColorIndex = c;
+			if (previous[c] < 0)
+				areas[c] = reachable;
+			work[work_count++] = k;
+		}
+		else
+		{
+			layers[k] = std::move(Layers[previous[c]]);
+			Stats.LayersReused++;
+			Stats.PolysReused += (int)layers[k].Polygons.size();
+		}
+	}
+
+	std::vector<double>& busy = _busy;
+	busy.assign(_MaxThreads(), 0.0);
+
+#pragma omp parallel for schedule(dynamic, 1) shared(work_count, work, layers, previous, areas, dirtycells, width, height, options, kept_count, busy)
+	for (int w = 0; w < work_count; ++w)
+	{
+		const double start = _Now();
+		Layer& layer = layers[work[w]];
+		const int c = layer.ColorIndex;
+		PolyPool& pool = _pools[c];
+
+		// Untouched polygons are kept, storage of others goes to pool
+		PolyList kept;
+		if (previous[c] >= 0)
+		{
+			PolyList& polys = Layers[previous[c]].Polygons;
+			for (auto& p : polys)
+			{
+				if (!_Overlaps(p.BoundingBox, dirtycells))
+					kept.push_back(std::move(p));
+			}
+			pool.Give(polys);
+		}
+		kept_count[w] = (int)kept.size();
+
+		const BBox area(areas[c].coords[0] + 1, areas[c].coords[1] + 1, areas[c].coords[2] + 1, areas[c].coords[3] + 1);
+		PolyList traced = _RetraceLayer(_edgenodes[c], area, dirtycells, bordered_width, options, pool);
+
+		// Both are in order traced, being raster order of their start cells
+		pool.Take(layer.Polygons);
+		layer.Polygons.reserve(kept.size() + traced.size());
+		std::merge(
+			std::make_move_iterator(kept.begin()), std::make_move_iterator(kept.end()),
+			std::make_move_iterator(traced.begin()), std::make_move_iterator(traced.end()),
+			std::back_inserter(layer.Polygons),
+			[](const Poly& a, const Poly& b) {
+				return (a.StartY < b.StartY) || ((a.StartY == b.StartY) && (a.StartX < b.StartX));
+			}
+		);
+
+		// New and removed polygons might change parents of untouched holes
+		_LinkHoles(layer.Polygons, width, height, pool);
+
+		_Arena().Rewind(0);
+		busy[_ThreadNum()] += _Now() - start;
+	}
+
+	// Storage of colors no longer found is kept, too
+	for (auto& layer : Layers)
+		_pools[layer.ColorIndex].Give(layer.Polygons);
+	Layers.swap(layers);
+
+	for (int w = 0; w < work_count; ++w)
+		Stats.PolysReused += kept_count[w];
+	Stats.Threads = (int)busy.size();
+	Stats.ParallelPaths = false;
+	Stats.LoadBalance = _LoadBalance(busy);
+}
+
+PolyList ImageTracer::_RetraceLayer(const EdgeNodeList& edgenodes, const BBox& area, const BBox& dirtycells, const int width, const Options& options, PolyPool& pool)
+{
+	const int area_width = area.coords[2] - area.coords[0] + 1;
+	const int area_height = area.coords[3] - area.coords[1] + 1;
+	const int area_length = area_width * area_height;
+
+	// Edge nodes given might extend beyond area
+	byte* layer = static_cast<byte*>(_Arena().Allocate(area_length, 16));
+	memset(layer, 0, area_length);
+	for (auto n : edgenodes)
+	{
+		const int row = (n.index / width) - area.coords[1];
+		const int col = (n.index % width) - area.coords[0];
+		if ((row >= 0) && (row < area_height) && (col >= 0) && (col < area_width))
+			layer[INDEX(row, col, area_width)] = n.type;
+	}
+
+	PathList paths = _PathScanDirty(layer, edgenodes, area, dirtycells, width, options, pool);
+
+	PolyList polys;
+	_AppendPolys(paths, polys);
+
+	return polys;
+}
+
+
+void ImageTracer::_TraceStream(const int width, const RowSource& source, const PolySink& sink, const Options& options, const int bandrows)
+{
+	if ((width <= 0) || (bandrows <= 0))
+		throw new TraceException("Invalid image or band size");
+
+	// Band of rows with last row of previous band kept in front of it, rows outside
+	// of image being of color index 255 (same as with _LayeringStep)
+	const int bordered_width = width + 2;
+	std::vector<byte> rows((bandrows + 1) * width, 255);
+	std::vector<byte> borderrow(width, 255);
+	std::vector<int> offsets(width);
+
+	// Edge nodes of current band, open contour fragments of each color
+	std::vector<EdgeNodeList> edgenodes(256);
+	std::vector<PathStitcher> stitchers(256);
+	std::vector<byte> layer;
+	PathFragmentList fragments;
+
+	// Scratch memory for walking and tracing contours
+	_arenas.resize(_MaxThreads());
+	_fitted.resize(_MaxThreads());
+
+	// Color indices found so far, checked same as by _Trace
+	bool present[256] = { false };
+	int color_count = 0;
+
+	int height = 0;
+	bool finished = false;
+	while (!finished)
+	{
+		const int count = source(rows.data() + width, bandrows);
+		if ((count < 0) || (count > bandrows))
+			throw new TraceException("Invalid row count");
+		finished = (count == 0);
+
+		const byte* band = rows.data() + width;
+		for (int k = 0; k < count * width; ++k)
+		{
+			if (!present[band[k]])
+			{
+				present[band[k]] = true;
+				color_count++;
+			}
+		}
+		if (present[255])
+			throw new TraceException("Color index 255 is reserved, please adjust your input");
+
+		// Contour around a single color image only gets closed by bottom border, 
+		// so nothing was passed to sink yet
+		if (finished && (color_count < 2))
+			throw new TraceException("Can't trace empty image");
+
+		// Bordered rows [j0, j1) get their edge nodes from this band, 
+		// last band being the bottom border
+		const int j0 = height + 1;
+		const int j1 = finished ? j0 + 1 : j0 + count;
+		for (int j = j0; j < j1; ++j)
+		{
+			const byte* above = (j > 1)   ? rows.data() + (j - j0) * width : borderrow.data();
+			const byte* below = !finished ? rows.data() + (j - j0 + 1) * width : borderrow.data();
+			_LayeringRow(above, below, width, j, offsets.data(), edgenodes.data());
+		}
+
+		// Layer area reaches one row beyond band wherever contours can cross into it, 
+		// so _ScanStripe looks for fragments entering there
+		const BBox area(0, (j0 > 1) ? j0 - 1 : j0, bordered_width - 1, finished ? j1 - 1 : j1);
+		const int area_length = bordered_width * (area.coords[3] - area.coords[1] + 1);
+		if ((int)layer.size() < area_length)
+			layer.resize(area_length, 0);
+
+		for (int c = 0; c < 256; ++c)
+		{
+			EdgeNodeList& nodes = edgenodes[c];
+			if (nodes.empty())
+				continue;
+
+			for (auto n : nodes)
+				layer[n.index - area.coords[1] * bordered_width] = n.type;
+
+			_ScanStripe(layer.data(), nodes.begin(), nodes.end(), area, bordered_width, j0, j1, fragments);
+
+			for (auto n : nodes)
+				layer[n.index - area.coords[1] * bordered_width] = 0;
+			nodes.clear();
+
+			// Tracing contours as soon as they're closed
+			for (auto& fragment : fragments)
+			{
+				if (fragment.IsClosed())
+					_TraceContour(fragment, c, sink, options);
+				else
+				{
+					PathFragment closed;
+					if (stitchers[c].Add(std::move(fragment), closed))
+						_TraceContour(closed, c, sink, options);
+				}
+			}
+			fragments.clear();
+		}
+
+		// Keeping last row for next band
+		if (!finished)
+		{
+			memcpy(rows.data(), rows.data() + count * width, width);
+			height += count;
+		}
+	}
+
+	for (auto& stitcher : stitchers)
+	{
+		if (stitcher.Pending())
+			throw new TraceException("Contours left open");
+	}
+}
+
+void ImageTracer::_TraceContour(const PathFragment& contour, const int color_index, const PolySink& sink, const Options& options)
+{
+	if (_Omitted((int)contour.cells.size(), options.pathomit))
+		return;
+
+	Arena& arena = _Arena();
+	const size_t mark = arena.Mark();
+
+	Path path(&arena);
+	_FragmentToPath(contour, path);
+	_TraceClosedPath(path, options, path.segments);
+
+	Poly poly = _ToPoly(path);
+	arena.Rewind(mark);
+	sink(color_index, poly);
+}
+
+
+// 1. Color quantization
+// Using a form of k-means clustering repeatead options.colorquantcycles times. http://en.wikipedia.org/wiki/Color_quantization
+//=> Skipped for now
+
+// 2. Layer separation and edge detection
+//
+// Edge node types ( ▓: this layer or 1; ░: not this layer or 0 )
+//
+// 12  ░░  ▓░  ░▓  ▓▓  ░░  ▓░  ░▓  ▓▓  ░░  ▓░  ░▓  ▓▓  ░░  ▓░  ░▓  ▓▓
+//
+// 48  ░░  ░░  ░░  ░░  ░▓  ░▓  ░▓  ░▓  ▓░  ▓░  ▓░  ▓░  ▓▓  ▓▓  ▓▓  ▓▓
+//     0   1   2   3   4   5   6   7   8   9   10  11  12  13  14  15
+void ImageTracer::_LayeringStep(byte* pixels, const int width, const int height, EdgeNodeList* edgenodes, int* histogram, BBox* colorbboxes)
+{
+	// Edge nodes are indexed in bordered coordinates, with border being virtual:
+	// Rows outside image are replaced by a row of color index 255, and first and last 
+	// column of each row are handled separately.
+	Arena& arena = _Arena();
+	const size_t mark = arena.Mark();
+	byte* borderrow = static_cast<byte*>(arena.Allocate(width, 16));
+	int* offsets = static_cast<int*>(arena.Allocate(width * sizeof(int), 16));
+	memset(borderrow, 255, width);
+
+	for (int j = 1; j <= height + 1; j++)
+	{
+		const byte* above = (j > 1)      ? pixels + (j - 2) * width : borderrow;
+		const byte* below = (j <= height) ? pixels + (j - 1) * width : borderrow;
+
+		// Histogram and bounding boxes for image row just entered
+		if (j <= height)
+		{
+			const int y = j - 1;
+			for (int x = 0; x < width; ++x)
+			{
+				const byte b = below[x];
+				BBox& bbox = colorbboxes[b];
+				if (!histogram[b]++)
+					bbox = BBox(x, y, x, y);
+				else
+				{
+					if (x < bbox.coords[0]) bbox.coords[0] = x;
+					if (x > bbox.coords[2]) bbox.coords[2] = x;
+					bbox.coords[3] = y;
+				}
+			}
+		}
+
+		_LayeringRow(above, below, width, j, offsets, edgenodes);
+	}
+
+	arena.Rewind(mark);
+}
+
+void ImageTracer::_LayeringRow(const byte* above, const byte* below, const int width, const int j, int* offsets, EdgeNodeList* edgenodes)
+{
+	// Kernel best suited for the CPU we're running on, all produce same results
+	static const Kernels::ScanWindowsFunc scanwindows = Kernels::ScanWindows(Kernels::Best());
+
+	const int row = j * (width + 2);
+
+	#define NODE(color) \
+		edgenodes[color].push_back(EdgeNode(index, (byte)( \
+			(tl == color ? 1 : 0) + \
+			(tr == color ? 2 : 0) + \
+			(bl == color ? 8 : 0) + \
+			(br == color ? 4 : 0) \
+		)))
+
+	// Border color 255 never gets a layer
+	#define NODES() \
+		if (tl != 255) \
+			NODE(tl); \
+		if ((tr != tl) && (tr != 255)) \
+			NODE(tr); \
+		if ((bl != tl) && (bl != tr) && (bl != 255)) \
+			NODE(bl); \
+		if ((br != tl) && (br != tr) && (br != bl) && (br != 255)) \
+			NODE(br);
+
+	// Left border column
+	{
+		const int index = row + 1;
+		const byte tl = 255, tr = above[0];
+		const byte bl = 255, br = below[0];
+		NODES();
+	}
+
+	// Inner windows with more than one color
+	const int count = scanwindows(above, below, 0, width - 1, offsets);
+	for (int o = 0; o < count; ++o)
+	{
+		const int k = offsets[o];
+		const int index = row + k + 2;
+		const byte tl = above[k], tr = above[k + 1];
+		const byte bl = below[k], br = below[k + 1];
+		NODES();
+	}
+
+	// Right border column
+	{
+		const int index = row + width + 1;
+		const byte tl = above[width - 1], tr = 255;
+		const byte bl = below[width - 1], br = 255;
+		NODES();
+	}
+
+	#undef NODES
+	#undef NODE
+}
+
+// 3. Walking through an edge node array, discarding edge node types 0 and 15 and creating paths from the rest.
+// Walk directions (dir): 0 > ; 1 ^ ; 2 < ; 3 v 
+// Adds point of cell (x, y) to path, growing its bounding box. Cells are in bordered 
+// coordinates, paths are not.
+static void _AddCell(Path& path, const int x, const int y)
+{
+	path.AddPoint(2 * (x - 1), 2 * (y - 1));
+
+	// Bounding box
+	if ((x - 1) < path.boundingbox.coords[0]) { path.boundingbox.coords[0] = x - 1; }
+	if ((x - 1) > path.boundingbox.coords[2]) { path.boundingbox.coords[2] = x - 1; }
+	if ((y - 1) < path.boundingbox.coords[1]) { path.boundingbox.coords[1] = y - 1; }
+	if ((y - 1) > path.boundingbox.coords[3]) { path.boundingbox.coords[3] = y - 1; }
+}
+
+// Finding the parent shape of a hole, being the innermost one indexed by outers whose bounding 
+// box includes the hole's one, -1 if there's none. Bounding boxes are looked up by index.
+template <typename BBoxAt>
+static int _FindParent(const BBoxGrid& outers, const BBox& holebbox, const int width, const int height, const BBoxAt& bboxat)
+{
+	// Any bounding box including the hole's one includes its top left corner
+	int parentidx = -1;
+	BBox parentbbox(-1, -1, width + 1, height + 1);
+	for (auto idx : outers.Candidates(holebbox.coords[0], holebbox.coords[1]))
+	{
+		const BBox& bbox = bboxat(idx);
+		if (bbox.Includes(holebbox) &&
+			parentbbox.Includes(bbox)
+		)
+		{
+			parentidx = idx;
+			parentbbox = bbox;
+		}
+	}
+	return parentidx;
+}
+
+// Adds hole to children of its parent, their storage being taken from pool
+static void _AddHoleChild(IntList& children, const int hole, PolyPool& pool)
+{
+	if (children.capacity() == 0)
+		pool.Take(children);
+	children.push_back(hole);
+}
+
+int ImageTracer::_WalkStep(const int type, int& dir, int& x, int& y) const
+{
+	const signed char *lookuprow = _pathscan_combined_lookup[type][dir];
+	if (lookuprow[1] < 0)
+		return -1;
+
+	dir = lookuprow[1];
+	x += lookuprow[2];
+	y += lookuprow[3];
+	return lookuprow[0];
+}
+
+bool ImageTracer::_AddPath(PathList& paths, const int pathomit, BBoxGrid& outers, const int width, const int height, PolyPool& pool)
+{
+	Path& path = paths.back();
+	if (_Omitted(path.PointCount(), pathomit))
+	{
+		paths.pop_back();
+		return false;
+	}
+
+	const int index = (int)paths.size() - 1;
+	if (path.isholepath)
+	{
+		// Parent might have been discarded by pathomit
+		const int parentidx = _FindParent(outers, path.boundingbox, width, height, [&paths](const int idx) -> const BBox& { return paths[idx].boundingbox; });
+		if (parentidx >= 0)
+			_AddHoleChild(paths[parentidx].holechildren, index, pool);
+	}
+	else
+		outers.Add(index, path.boundingbox);
+	return true;
+}
+
+PathList ImageTracer::_PathScan(byte* layer, const EdgeNodeList& edgenodes, const BBox& area, const int width, const int height, const Options& options, const bool fused, PolyPool& pool, FlatResult* flat)
+{
+	PathList::iterator pa;
+	int px = 0;
+	int py = 0;
+	int dir = 0;
+	bool pathfinished = true;
+	bool holepath = false;
+
+	// Fused tracing releases scratch data of each path as soon as it's done
+	Arena& arena = _Arena();
+	size_t mark = 0;
+
+	PathList paths(&arena);
+
+	const int area_width = area.coords[2] - area.coords[0] + 1;
+
+	// Non-hole paths found so far, indexed by their bounding boxes (path coordinates)
+	BBoxGrid& outers = _Grid();
+	outers.Reset(BBox(area.coords[0] - 1, area.coords[1] - 1, area.coords[2] - 1, area.coords[3] - 1));
+
+	#define L(row,col) layer[INDEX((row) - area.coords[1], (col) - area.coords[0], area_width)]
+	// Edge nodes are ordered by index, so this is same as scanning all rows and columns
+	for (auto node : edgenodes)
+	{
+		const int j = node.index / width;
+		const int i = node.index % width;
+
+		if ((L(j, i) == 4) || (L(j, i) == 11))
+		{ // Other values are not valid
+
+			// Init
+			px = i;
+			py = j;
+			pa = paths.insert(paths.end(), Path(&arena));
+			mark = arena.Mark();
+			pa->boundingbox = BBox(px, py, px, py);
+			pa->startx = px - 1;
+			pa->starty = py - 1;
+			pathfinished = false;
+			holepath = (L(j, i) == 11);
+			dir = 1;
+
+			// Path points loop
+			while (!pathfinished)
+			{
+				// New path point
+				_AddCell(*pa, px, py);
+
+				// Next: clear this cell, turn if required, walk forward. Cells pathscan 
+				// gets to can always be walked.
+				byte& cell = L(py, px);
+				cell = (byte)_WalkStep(cell, dir, px, py);
+
+				// Close path
+				if ((2 * (px - 1) == pa->xs[0]) && (2 * (py - 1) == pa->ys[0]))
+				{
+					pathfinished = true;
+					pa->isholepath = holepath;
+
+					if (_AddPath(paths, options.pathomit, outers, width, height, pool))
+					{
+						// Tracing while path is still in cache, keeping segments only
+						if (fused && flat)
+						{
+							_TraceClosedPath(*pa, options, flat->Segments);
+							flat->PolyOffsets.push_back((int)flat->Segments.size());
+						}
+						else if (fused)
+						{
+							pool.Take(pa->segments);
+							_TraceClosedPath(*pa, options, pa->segments);
+						}
+					}
+
+					if (fused)
+						arena.Rewind(mark);
+
+				}// End of Close path
+
+			}// End of Path points loop
+
+		}// End of Follow path
+
+	}// End of edge nodes loop
+	#undef L
+
+	return paths;
+}
+
+// Walks contours of layer without modifying it, saddle cells (types 5 and 10) having two 
+// pieces which are walked separately. Returns piece of cell type entered in direction dir.
+static inline int _Piece(const int type, const int dir)
+{
+	if (type == 5)
+		return (dir <= 1) ? 0 : 1;
+	if (type == 10)
+		return ((dir == 1) || (dir == 2)) ? 1 : 0;
+	return 0;
+}
+
+void ImageTracer::_ScanStripe(const byte* layer, EdgeNodeList::const_iterator first, EdgeNodeList::const_iterator last, const BBox& area, const int width, const int row0, const int row1, PathFragmentList& fragments)
+{
+	const int area_width = area.coords[2] - area.coords[0] + 1;
+
+	// Walked pieces of cells within stripe, one bit per piece
+	Arena& arena = _Arena();
+	const size_t mark = arena.Mark();
+	const int visited_length = (row1 - row0) * area_width;
+	byte* visited = static_cast<byte*>(arena.Allocate(visited_length, 16));
+	memset(visited, 0, visited_length);
+
+	#define L(row,col) layer[INDEX((row) - area.coords[1], (col) - area.coords[0], area_width)]
+	#define V(row,col) visited[INDEX((row) - row0, (col) - area.coords[0], area_width)]
+
+	// Walks from cell (x, y) entered in direction dir until leaving the stripe, or for
+	// contours within stripe, until getting back to the starting cell. 
+	// Returns crossing left through, or -1.
+	auto walk = [&](int x, int y, int dir, const bool open, PathFragment& fragment) -> long long
+	{
+		const int x0 = x, y0 = y;
+		do
+		{
+			const int type = L(y, x);
+			V(y, x) |= (byte)(1 << _Piece(type, dir));
+
+			const Cell cell(x, y);
+			if (fragment.cells.empty() || (cell < fragment.cells[fragment.first]))
+			{
+				fragment.first = (int)fragment.cells.size();
+				fragment.firsttype = (byte)type;
+			}
+			fragment.cells.push_back(cell);
+
+			const int y_walked = y;
+			_WalkStep(type, dir, x, y);
+
+			if ((y < row0) || (y >= row1))
+				return (long long)((y > y_walked) ? y : y + 1) * width + x;
+		} while (open || (x != x0) || (y != y0));
+
+		return -1;
+	};
+
+	auto isvisited = [&](const int x, const int y, const int dir) -> bool
+	{
+		return (V(y, x) & (1 << _Piece(L(y, x), dir))) != 0;
+	};
+
+	// Fragments entering from above
+	if (row0 > area.coords[1])
+	{
+		for (auto n = first; (n != last) && (n->index < (row0 + 1) * width); ++n)
+		{
+			const int x = n->index % width;
+			if ((_pathscan_combined_lookup[n->type][3][1] != -1) && !isvisited(x, row0, 3))
+			{
+				PathFragment fragment;
+				fragment.ends[0] = (long long)row0 * width + x;
+				fragment.ends[1] = walk(x, row0, 3, true, fragment);
+				fragments.push_back(std::move(fragment));
+			}
+		}
+	}
+
+	// Fragments entering from below
+	if (row1 <= area.coords[3])
+	{
+		auto n = std::lower_bound(first, last, (row1 - 1) * width, [](const EdgeNode& node, const int index) { return node.index < index; });
+		for (; n != last; ++n)
+		{
+			const int x = n->index % width;
+			if ((_pathscan_combined_lookup[n->type][1][1] != -1) && !isvisited(x, row1 - 1, 1))
+			{
+				PathFragment fragment;
+				fragment.ends[0] = (long long)row1 * width + x;
+				fragment.ends[1] = walk(x, row1 - 1, 1, true, fragment);
+				fragments.push_back(std::move(fragment));
+			}
+		}
+	}
+
+	// Remaining contours are within stripe, each starting at its first cell in raster order.
+	// With pathscan, type 10 cells get type 11 by then.
+	for (auto n = first; n != last; ++n)
+	{
+		const int x = n->index % width;
+		const int y = n->index / width;
+		if (((n->type == 4) || (n->type == 11) || (n->type == 10)) && !isvisited(x, y, 1))
+		{
+			PathFragment fragment;
+			walk(x, y, 1, false, fragment);
+			fragments.push_back(std::move(fragment));
+		}
+	}
+
+	#undef V
+	#undef L
+
+	arena.Rewind(mark);
+}
+
+PathList ImageTracer::_PathScanStripes(const byte* layer, const EdgeNodeList& edgenodes, const BBox& area, const int width, const int height, const int pathomit, const int stripes, PolyPool& pool)
+{
+	const int area_height = area.coords[3] - area.coords[1] + 1;
+
+	// Scanning stripes
+	std::vector<PathFragmentList> fragments(stripes);
+#pragma omp parallel for schedule(dynamic, 1) shared(layer, edgenodes, area, fragments)
+	for (int s = 0; s < stripes; ++s)
+	{
+		const int row0 = area.coords[1] + (int)((long long)area_height * s / stripes);
+		const int row1 = area.coords[1] + (int)((long long)area_height * (s + 1) / stripes);
+		auto byindex = [](const EdgeNode& node, const int index) { return node.index < index; };
+		auto first = std::lower_bound(edgenodes.begin(), edgenodes.end(), row0 * width, byindex);
+		auto last  = std::lower_bound(first, edgenodes.end(), row1 * width, byindex);
+		_ScanStripe(layer, first, last, area, width, row0, row1, fragments[s]);
+	}
+
+	// Stitching fragments
+	PathStitcher stitcher;
+	PathFragmentList contours;
+	for (auto& stripe : fragments)
+	{
+		for (auto& fragment : stripe)
+		{
+			if (fragment.IsClosed())
+				contours.push_back(std::move(fragment));
+			else
+			{
+				PathFragment closed;
+				if (stitcher.Add(std::move(fragment), closed))
+					contours.push_back(std::move(closed));
+			}
+		}
+		PathFragmentList().swap(stripe);
+	}
+
+	// Same order as pathscan
+	std::sort(contours.begin(), contours.end(), [](const PathFragment& f1, const PathFragment& f2) { 
+		return f1.cells[f1.first] < f2.cells[f2.first]; 
+	});
+
+	PathList paths(&_Arena());
+	BBoxGrid& outers = _Grid();
+	outers.Reset(BBox(area.coords[0] - 1, area.coords[1] - 1, area.coords[2] - 1, area.coords[3] - 1));
+	for (auto& contour : contours)
+	{
+		PathList::iterator pa = paths.insert(paths.end(), Path(&_Arena()));
+		_FragmentToPath(contour, *pa);
+		_AddPath(paths, pathomit, outers, width, height, pool);
+	}
+
+	return paths;
+}
+
+void ImageTracer::_FragmentToPath(const PathFragment& fragment, Path& path)
+{
+	const int count = (int)fragment.cells.size();
+	const Cell& start = fragment.cells[fragment.first];
+
+	path.ReservePoints(count);
+	path.boundingbox = BBox(start.x - 1, start.y - 1, start.x - 1, start.y - 1);
+	path.isholepath = (fragment.firsttype == 11) || (fragment.firsttype == 10);
+	path.startx = start.x - 1;
+	path.starty = start.y - 1;
+
+	for (int i = 0; i < count; ++i)
+	{
+		const Cell& cell = fragment.cells[(fragment.first + i) % count];
+		_AddCell(path, cell.x, cell.y);
+	}
+}
+
+PathList ImageTracer::_PathScanDirty(byte* layer, const EdgeNodeList& edgenodes, const BBox& area, const BBox& dirtycells, const int width, const Options& options, PolyPool& pool)
+{
+	Arena& arena = _Arena();
+	PathList paths(&arena);
+
+	const int area_width = area.coords[2] - area.coords[0] + 1;
+
+	#define L(row,col) layer[INDEX((row) - area.coords[1], (col) - area.coords[0], area_width)]
+	for (auto node : edgenodes)
+	{
+		const int j = node.index / width;
+		const int i = node.index % width;
+		if ((j < area.coords[1]) || (j > area.coords[3]) || (i < area.coords[0]) || (i > area.coords[2]))
+			continue;
+		if ((L(j, i) != 4) && (L(j, i) != 11))
+			continue;
+
+		int px = i;
+		int py = j;
+		int dir = 1;
+		const bool holepath = (L(j, i) == 11);
+		PathList::iterator pa = paths.insert(paths.end(), Path(&arena));
+		const size_t mark = arena.Mark();
+		pa->boundingbox = BBox(px, py, px, py);
+		pa->startx = px - 1;
+		pa->starty = py - 1;
+
+		bool closed = false;
+		while (true)
+		{
+			_AddCell(*pa, px, py);
+
+			// Cell walked before: Contour was entered somewhere behind its start, after 
+			// walking it from there was dropped
+			byte& cell = L(py, px);
+			const int type = _WalkStep(cell, dir, px, py);
+			if (type < 0)
+				break;
+			cell = (byte)type;
+
+			if ((2 * (px - 1) == pa->xs[0]) && (2 * (py - 1) == pa->ys[0]))
+			{
+				closed = true;
+				break;
+			}
+
+			if ((px < area.coords[0]) || (px > area.coords[2]) || (py < area.coords[1]) || (py > area.coords[3]))
+				break;
+		}
+
+		// Contours not touching dirty cells are same as before
+		if (closed && !_Omitted(pa->PointCount(), options.pathomit) && _Overlaps(pa->boundingbox, dirtycells))
+		{
+			pa->isholepath = holepath;
+			pool.Take(pa->segments);
+			_TraceClosedPath(*pa, options, pa->segments);
+		}
+		else
+			paths.pop_back();
+
+		arena.Rewind(mark);
+	}
+	#undef L
+
+	return paths;
+}
+
+void ImageTracer::_LinkHoles(PolyList& polys, const int width, const int height, PolyPool& pool)
+{
+	for (auto& p : polys)
+		p.HoleChildren.clear();
+
+	// Same as pathscan, with non-hole polygons indexed as they're passed
+	BBoxGrid& outers = _Grid();
+	outers.Reset(BBox(0, 0, width, height));
+	for (int i = 0; i < (int)polys.size(); ++i)
+	{
+		if (!polys[i].IsHole)
+		{
+			outers.Add(i, polys[i].BoundingBox);
+			continue;
+		}
+
+		const int parentidx = _FindParent(outers, polys[i].BoundingBox, width, height, [&polys](const int idx) -> const BBox& { return polys[idx].BoundingBox; });
+		if (parentidx >= 0)
+			_AddHoleChild(polys[parentidx].HoleChildren, i, pool);
+	}
+}
+
+// 4. interpollating between path points for nodes with 8 directions ( East, SouthEast, S, SW, W, NW, N, NE )
+PathList ImageTracer::_InterNodes(const PathList& paths, const Options& options, const bool parallel)
+{
+	const int count = (int)paths.size();
+	PathList ins(&_Arena());
+	ins.resize(count);
+
+	// paths loop, handed out in fixed chunks so each thread gets same paths for same layer
+#pragma omp parallel for schedule(static, 16) if(parallel) shared(paths, options, count, ins)
+	for (int i = 0; i < count; ++i)
+	{
+		ins[i] = Path(&_Arena());
+		_InterNodePath(paths[i], options, ins[i]);
+	}
+		
+	return ins;
+
+}
+
+void ImageTracer::_InterNodePath(const Path& path, const Options& options, Path& ins)
+{
+	ins.boundingbox  = path.boundingbox;
+	ins.isholepath   = path.isholepath;
+	const int palen = path.PointCount();
+
+	// Right angle corners add a point each, so output size is known up front
+	int nlen = palen;
+	if (options.rightangleenhance)
+	{
+		for (int pcnt = 0; pcnt < palen; pcnt++)
+		{
+			if (_TestRightAngle(path, (pcnt - 2 + palen) % palen, (pcnt - 1 + palen) % palen, pcnt, (pcnt + 1) % palen, (pcnt + 2) % palen))
+				nlen++;
+		}
+	}
+	ins.ReservePoints(nlen);
+	ins.linesegments.reserve(nlen);
+
+	// pathpoints loop
+	for (int pcnt = 0; pcnt < palen; pcnt++)
+	{
+		// next and previous point indexes
+		int nextidx  = (pcnt + 1) % palen;
+		int nextidx2 = (pcnt + 2) % palen;
+		int previdx  = (pcnt - 1 + palen) % palen;
+		int previdx2 = (pcnt - 2 + palen) % palen;
+
+		// Midpoints of integer coordinates are whole half units
+		const int x = path.xs[pcnt], y = path.ys[pcnt];
+		const int ptx = (x + path.xs[nextidx]) / 2;
+		const int pty = (y + path.ys[nextidx]) / 2;
+
+		// right angle enhance
+		if (options.rightangleenhance && _TestRightAngle(path, previdx2, previdx, pcnt, nextidx, nextidx2))
+		{
+			// Fix previous direction
+			if (ins.PointCount() > 0)
+			{
+				ins.linesegments.back() = (signed char)_GetDirection(
+					ins.xs.back(), ins.ys.back(),
+					x, y
+				);
+			}
+
+			// This corner point
+			ins.AddPoint(x, y);
+			ins.linesegments.push_back((signed char)_GetDirection(
+				x, y,
+				ptx, pty
+			));
+
+		}// End of right angle enhance
+
+		// interpolate between two path points
+		ins.AddPoint(ptx, pty);
+		ins.linesegments.push_back((signed char)_GetDirection(
+			ptx, pty,
+			(path.xs[nextidx] + path.xs[nextidx2]) / 2, 
+			(path.ys[nextidx] + path.ys[nextidx2]) / 2
+		));
+
+	}// End of pathpoints loop
+}
+
+bool ImageTracer::_TestRightAngle(const Path& path, const int idx1, const int idx2, const int idx3, const int idx4, const int idx5) const
+{
+	const CoordList& xs = path.xs;
+	const CoordList& ys = path.ys;
+	return (((xs[idx3] == xs[idx1]) &&
+			 (xs[idx3] == xs[idx2]) &&
+			 (ys[idx3] == ys[idx4]) &&
+			 (ys[idx3] == ys[idx5])
+			) ||
+			((ys[idx3] == ys[idx1]) &&
+			 (ys[idx3] == ys[idx2]) &&
+			 (xs[idx3] == xs[idx4]) &&
+			 (xs[idx3] == xs[idx5])
+			)
+	);
+}
+
+template <typename T> __forceinline int sign(const T val1, const T val2) {
+    return (val1 < val2) - (val2 < val1);
+}
+
+int ImageTracer::_GetDirection(const int x1, const int y1, const int x2, const int y2) const
+{
+	const int sx = sign(x1, x2) + 1;
+	const int sy = sign(y1, y2) + 1;
 	return _direction_lookup[sx][sy];
 }
 
@@ -513,150 +2850,373 @@ int ImageTracer::_GetDirection(const Point& pt1, const Point& pt2) const
 // 5.4. Fit a quadratic spline through errorpoint (project this to get controlpoint), then measure errors on every point in the sequence
 // 5.5. If the spline fails (distance error > qtres), find the point with the biggest error, set splitpoint = fitting point
 // 5.6. Split sequence and recursively apply 5.2. - 5.6. to startpoint-splitpoint and splitpoint-endpoint sequences
-Path ImageTracer::_TracePath(const Path& path, const float ltres, const float qtres)
+void ImageTracer::_TracePath(const Path& path, const float ltres, const float qtres, const bool parallel, SegmentList& segments)
 {
-	Path smp;
-	smp.boundingbox = path.boundingbox;
-	//TODO: smp.holechildren = std::stack<int>(path.holechildren);
-	smp.isholepath = path.isholepath;
-
-	PointList::const_iterator p = path.points.begin();
-	IntList::const_iterator line = path.linesegments.begin();
-	IntList::const_iterator last = line + (path.linesegments.size() - 1);
-	IntList::const_iterator seq_end;
-	PointList::const_iterator p_end;
-	while (line != path.linesegments.end())
+	const CodeList& lines = path.linesegments;
+	const int count = (int)lines.size();
+	const int last = count - 1;
+	int p = 0;
+	int p_end;
+
+	// When running in parallel, sequences are collected first and fitted afterwards
+	std::vector< std::pair<int, int> >& sequences = _sequences;
+	if (parallel)
+		sequences.clear();
+
+	// Segments are collected in a list kept per thread, so result is allocated once with
+	// its final size instead of growing (and being copied) along with fitting
+	SegmentList& fitted = _Fitted();
+	fitted.clear();
+
+	while (p != count)
 	{
 		// 5.1. Find sequences of points with only 2 segment types
-		int segtype1 = *line;
+		int segtype1 = lines[p];
 		int segtype2 = -1;
-		seq_end = line + 1;
 		p_end = p + 1;
 
 		while (
-			((*seq_end == segtype1) || (*seq_end == segtype2) || (segtype2 == -1))
-			&& (seq_end < last))
+			((lines[p_end] == segtype1) || (lines[p_end] == segtype2) || (segtype2 == -1))
+			&& (p_end < last))
 		{
-			if ((*seq_end != segtype1) && (segtype2 == -1)) 
-				segtype2 = *seq_end;
-			seq_end++;
+			if ((lines[p_end] != segtype1) && (segtype2 == -1)) 
+				segtype2 = lines[p_end];
 			p_end++;
 		}
-		if (seq_end == last) 
-		{ 
-			seq_end = path.linesegments.begin(); 
-			p_end   = path.points.begin(); 
-		}
+		if (p_end == last) 
+			p_end = 0; 
 
 		// 5.2. - 5.6. Split sequence and recursively apply 5.2. - 5.6. to startpoint-splitpoint and splitpoint-endpoint sequences
-		/*smp.segments =*/ smp.segments.Concat(_FitSeq(path, ltres, qtres, p, p_end));
+		if (parallel)
+			sequences.push_back(std::make_pair(p, p_end));
+		else
+			_FitSeq(path, ltres, qtres, p, p_end, fitted);
 
 		// forward pcnt;
-		if (seq_end != path.linesegments.begin()) 
-		{ 
-			line = seq_end; 
+		if (p_end != 0) 
 			p = p_end; 
-		} 
 		else 
 			break;
 
 	}// End of pcnt loop
 
-	return smp;
+	if (parallel)
+	{
+		// Segments of each sequence keep their storage for next path, sequences being 
+		// dealt round robin so each thread's scratch memory fits them again
+		const int seq_count = (int)sequences.size();
+		std::vector<SegmentList>& seqsegments = _seqsegments;
+		if ((int)seqsegments.size() < seq_count)
+			seqsegments.resize(seq_count);
+		for (int i = 0; i < seq_count; ++i)
+			seqsegments[i].clear();
+
+#pragma omp parallel for schedule(static, 1) if(seq_count > 1) shared(path, ltres, qtres, sequences, seq_count, seqsegments)
+		for (int i = 0; i < seq_count; ++i)
+			_FitSeq(path, ltres, qtres, sequences[i].first, sequences[i].second, seqsegments[i]);
+
+		for (int i = 0; i < seq_count; ++i)
+			fitted.Concat(seqsegments[i]);
+	}
+
+	segments.Concat(fitted);
 }
 
-// 5.2. - 5.6. recursively fitting a straight or quadratic line segment on this sequence of path nodes,
+// 5.2. - 5.6. fitting straight or quadratic line segments on this sequence of path nodes,
 // called from tracepath()
-SegmentList ImageTracer::_FitSeq(const Path& path, const float ltres, const float qtres, PointList::const_iterator seq_start, PointList::const_iterator seq_end)
+void ImageTracer::_FitSeq(const Path& path, const float ltres, const float qtres, const int seq_start, const int seq_end, SegmentList& segments)
 {
-	SegmentList segments;
+	// Parts are split at a point between their ends, so each part still to be fitted starts 
+	// where the one before it ended and only their ends need to be kept. Innermost one is on top, 
+	// so segments are appended in same order as when recursing into first part, then second one.
+	Arena& arena = _Arena();
+	const size_t mark = arena.Mark();
+	{
+		IndexStack ends(&arena);
+		ends.reserve(32);
+		ends.push_back(seq_end);
 
-	// variables
-	PointList::const_iterator errorpoint = seq_start;
-	float errorval = 0;
-	float dist2;
-	bool curvepass = true;
-	float tl = (float)path.points.distance(seq_start, seq_end);
+		int start = seq_start;
+		while (!ends.empty())
+		{
+			const int end = ends.back();
+			const int splitpoint = _FitSegment(path, ltres, qtres, start, end, segments);
+			if (splitpoint < 0)
+			{
+				start = end;
+				ends.pop_back();
+			}
+			else
+				ends.push_back(splitpoint);
+		}
+	}
+	arena.Rewind(mark);
+}
 
-	// 5.2. Fit a straight line on the sequence
-	float pl;
-	Point v = (*seq_end - *seq_start) / tl;
-	PointList::const_iterator p = path.points.next(seq_start);
-	while (p != seq_end)
-	{
-		pl = (float)path.points.distance(seq_start, p);
+// 5.2. - 5.5. fitting a straight or quadratic line segment on this part of a sequence
+int ImageTracer::_FitSegment(const Path& path, const float ltres, const float qtres, const int seq_start, const int seq_end, SegmentList& segments)
+{
+	// Kernels best suited for the CPU we're running on, all produce same results
+	static const Kernels::LineErrorsFunc lineerrors = Kernels::LineErrors(Kernels::Best());
+	static const Kernels::SplineErrorsFunc splineerrors = Kernels::SplineErrors(Kernels::Best());
 
-		Point pt = *p - (*seq_start + (v * pl));
-		dist2 = (pt.x * pt.x) + (pt.y * pt.y);
+	const Point start = path.PointAt(seq_start);
+	const Point end = path.PointAt(seq_end);
 
-		if (dist2 > ltres) { curvepass = false; }
-		if (dist2 > errorval) { errorpoint = p; errorval = dist2; }
+	// variables
+	const int len = path.Distance(seq_start, seq_end);
+	float tl = (float)len;
+
+	// Points between start and end wrap around at most once, so they're split into 
+	// two contiguous spans: [first, first + count1) and [0, count2)
+	const int first = path.Next(seq_start);
+	const int inner = (len > 1) ? len - 1 : 0;
+	const int count1 = (first + inner <= path.PointCount()) ? inner : path.PointCount() - first;
+	const int count2 = inner - count1;
+	const int* xs = path.xs.data();
+	const int* ys = path.ys.data();
+
+	// 5.2. Fit a straight line on the sequence
+	Point v = (end - start) / tl;
+	float errorval = 0;
+	int errorindex = 0;
+	bool curvepass = !lineerrors(xs + first, ys + first, count1, 1, start.x, start.y, v.x, v.y, ltres, errorval, errorindex);
+	curvepass = !lineerrors(xs, ys, count2, 1 + count1, start.x, start.y, v.x, v.y, ltres, errorval, errorindex) && curvepass;
 
-		p = path.points.next(p);
-	}
 	// return straight line if fits
 	if (curvepass)
 	{
-		segments.push_back(Segment::Line(*seq_start, *seq_end));
-		return segments;
+		segments.push_back(Segment::Line(start, end));
+		return -1;
 	}
 
 	// 5.3. If the straight line fails (distance error>ltres), find the point with the biggest error
-	PointList::const_iterator fitpoint = errorpoint;
-	curvepass = true;
-	errorval = 0;
+	int fitpoint = path.Next(seq_start, errorindex);
 
 	// 5.4. Fit a quadratic spline through this point, measure errors on every point in the sequence
 	// helpers and projecting to get control point
-	float t = path.points.distance(seq_start, fitpoint) / tl;
+	float t = path.Distance(seq_start, fitpoint) / tl;
 	float t1 = (1 - t) * (1 - t);
 	float t2 = 2 * (1 - t) * t;
 	float t3 = t * t;
-	Point cp = ((*seq_start * t1) + (*seq_end * t3) - *fitpoint) / -t2;
-
-	// Check every point
-	p = path.points.next(seq_start);
-	while (p != seq_end)
-	{
-		t = path.points.distance(seq_start, p) / tl;
-		t1 = (1 - t) * (1 - t);
-		t2 = 2 * (1 - t) * t;
-		t3 = t * t;
+	Point cp = ((start * t1) + (end * t3) - path.PointAt(fitpoint)) / -t2;
 
-		Point pt = *p - ((*seq_start * t1) + (cp * t2) + (*seq_end * t3));
-		dist2 = (pt.x * pt.x) + (pt.y * pt.y);
+	// Check every point, stopping at the first one failing
+	curvepass = 
+		!splineerrors(xs + first, ys + first, count1, 1, tl, start.x, start.y, cp.x, cp.y, end.x, end.y, qtres) &&
+		!splineerrors(xs, ys, count2, 1 + count1, tl, start.x, start.y, cp.x, cp.y, end.x, end.y, qtres);
 
-		if (dist2 > qtres) { curvepass = false; }
-		if (dist2 > errorval) { errorpoint = p; errorval = dist2; }
-
-		p = path.points.next(p);
-	}
 	// return spline if fits
 	if (curvepass)
 	{
-		segments.push_back(Segment::QuadSpline(*seq_start, cp, *seq_end));
-		return segments;
+		segments.push_back(Segment::QuadSpline(start, cp, end));
+		return -1;
 	}
 
 	// 5.5. If the spline fails (distance error>qtres), find the point with the biggest error
-	PointList::const_iterator splitpoint = fitpoint;
-
-	// 5.6. Split sequence and recursively apply 5.2. - 5.6. to startpoint-splitpoint and splitpoint-endpoint sequences
-	return _FitSeq(path, ltres, qtres, seq_start, splitpoint).Concat(
-		_FitSeq(path, ltres, qtres, splitpoint, seq_end)
-	);
+	// 5.6. is done by caller, splitting sequence at fitting point
+	return fitpoint;
 }
 
 // 5. Batch tracing paths
-PathList ImageTracer::_BatchTracePaths(const PathList& internodepaths, const float ltres, const float qtres)
+PathList ImageTracer::_BatchTracePaths(const PathList& internodepaths, const float ltres, const float qtres, const bool parallel, PolyPool& pool)
 {
-	PathList btracedpaths;
+	const int count = (int)internodepaths.size();
+	PathList btracedpaths(&_Arena());
+	btracedpaths.resize(count);
 
-	for (auto p : internodepaths)
-		btracedpaths.push_back(_TracePath(p, ltres, qtres));
+	// Pool is not thread safe, so storage is handed out up front
+	for (auto& p : btracedpaths)
+		pool.Take(p.segments);
+
+	// Enough paths to keep all threads busy: Trace them in parallel, in fixed chunks 
+	// same as interpolating them, otherwise have sequences of each path fitted in parallel.
+	const bool parallel_paths = parallel && (count >= _MaxThreads());
+#pragma omp parallel for schedule(static, 16) if(parallel_paths) shared(internodepaths, ltres, qtres, parallel, count, btracedpaths)
+	for (int i = 0; i < count; ++i)
+		_TracePath(internodepaths[i], ltres, qtres, parallel && !parallel_paths, btracedpaths[i].segments);
 
 	return btracedpaths;
 }
 
+void ImageTracer::_TraceClosedPath(Path& path, const Options& options, SegmentList& segments)
+{
+	Path ins(&_Arena());
+	_InterNodePath(path, options, ins);
+	_TracePath(ins, options.ltres, options.qtres, false, segments);
+
+	CoordList().swap(path.xs);
+	CoordList().swap(path.ys);
+	CodeList().swap(path.linesegments);
+}
+
+
+//*****************************************************************************
+
+TracerContext::TracerContext()
+{ }
+
+const ImageTracer* TracerContext::Trace(byte* pixels, const int width, const int height, const Options& options)
+{
+	try
+	{
+		_tracer._Trace(pixels, width, height, options);
+		_tracer._ReservePools();
+	}
+	catch (...)
+	{
+		// Layers might be incomplete, so they're not reused
+		_tracer.Layers.clear();
+		return nullptr;
+	}
+	return &_tracer;
+}
+
+const ImageTracer* TracerContext::Retrace(byte* pixels, const int width, const int height, const BBox& dirty, const Options& options)
+{
+	try
+	{
+		if (_tracer.Layers.empty())
+			_tracer._Trace(pixels, width, height, options);
+		else
+			_tracer._Retrace(pixels, width, height, dirty, options);
+		_tracer._ReservePools();
+	}
+	catch (...)
+	{
+		_tracer.Layers.clear();
+		return nullptr;
+	}
+	return &_tracer;
+}
+
+
+//*****************************************************************************
+
+FrameStats::FrameStats()
+	: FullTrace(false)
+	, Layers(0)
+	, LayersReused(0)
+	, Polys(0)
+	, PolysReused(0)
+{ }
+
+
+//*****************************************************************************
+
+SequenceTracer::SequenceTracer()
+	: _width(0)
+	, _height(0)
+{ }
+
+const ImageTracer* SequenceTracer::TraceFrame(byte* pixels, const int width, const int height, const Options& options)
+{
+	Stats = FrameStats();
+
+	const bool continued = !_previous.empty() && (width == _width) && (height == _height) &&
+		(options.ltres == _options.ltres) && (options.qtres == _options.qtres) &&
+		(options.pathomit == _options.pathomit) && (options.rightangleenhance == _options.rightangleenhance);
+
+	// Rows to store for comparing next frame, only changed ones if frame continues sequence
+	int row0 = 0, row1 = height - 1;
+
+	const ImageTracer* tracer = nullptr;
+	if (continued)
+	{
+		BBox changed;
+		if (_ChangedArea(pixels, changed))
+		{
+			row0 = changed.coords[1];
+			row1 = changed.coords[3];
+		}
+		else
+			row1 = -1;
+
+		// Changes all over the frame: Retracing would scan most of it anyway
+		const double area = (double)(changed.coords[2] - changed.coords[0] + 1) * (changed.coords[3] - changed.coords[1] + 1);
+		Stats.ChangedArea = changed;
+		Stats.FullTrace = (row1 >= 0) && (area > _retrace_max_area * width * height);
+		tracer = Stats.FullTrace ?
+			_context.Trace(pixels, width, height, options) :
+			_context.Retrace(pixels, width, height, changed, options);
+	}
+	else
+	{
+		Stats.ChangedArea = BBox(0, 0, width - 1, height - 1);
+		Stats.FullTrace = true;
+		tracer = _context.Trace(pixels, width, height, options);
+	}
+
+	if (!tracer)
+	{
+		Reset();
+		return nullptr;
+	}
+
+	if (!continued)
+	{
+		_previous.resize((size_t)width * height);
+		_width = width;
+		_height = height;
+		_options = options;
+	}
+	if (row1 >= row0)
+		memcpy(_previous.data() + (size_t)row0 * width, pixels + (size_t)row0 * width, (size_t)(row1 - row0 + 1) * width);
+
+	Stats.Layers = (int)tracer->Layers.size();
+	for (auto& layer : tracer->Layers)
+		Stats.Polys += (int)layer.Polygons.size();
+	if (!Stats.FullTrace)
+	{
+		Stats.LayersReused = tracer->Stats.LayersReused;
+		Stats.PolysReused = tracer->Stats.PolysReused;
+	}
+
+	return tracer;
+}
+
+void SequenceTracer::Reset()
+{
+	std::vector<byte>().swap(_previous);
+	_width = 0;
+	_height = 0;
+}
+
+bool SequenceTracer::_ChangedArea(const byte* pixels, BBox& area) const
+{
+	int l = _width, t = -1, r = -1, b = -1;
+	for (int y = 0; y < _height; ++y)
+	{
+		const byte* row = pixels + (size_t)y * _width;
+		const byte* prev = _previous.data() + (size_t)y * _width;
+		if (memcmp(row, prev, _width) == 0)
+			continue;
+
+		if (t < 0)
+			t = y;
+		b = y;
+
+		// Only columns beyond those found so far need to be checked
+		int x = 0;
+		while ((x < l) && (row[x] == prev[x]))
+			++x;
+		l = std::min(l, x);
+
+		x = _width - 1;
+		while ((x > r) && (row[x] == prev[x]))
+			--x;
+		r = std::max(r, x);
+	}
+
+	if (t < 0)
+	{
+		area = BBox();
+		return false;
+	}
+
+	area = BBox(l, t, r, b);
+	return true;
+}
+
 
 };
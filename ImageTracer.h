@@ -5,6 +5,11 @@
 
 #include <vector>
 #include <stack>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <iterator>
 
 
 namespace ImageTracer 
@@ -21,14 +26,99 @@ namespace ImageTracer
 	};
 
 
+	// Monotonic allocator for scratch data: Allocations are served from large blocks and 
+	// never freed one by one, instead the arena gets rewound to a previous mark as a whole.
+	// Blocks are kept for reuse until the arena is destroyed.
+	class Arena
+	{
+	public:
+		Arena();
+
+		void* Allocate(const size_t bytes, const size_t align);
+
+		// Position to rewind to, releasing everything allocated after it
+		size_t Mark() const;
+		void   Rewind(const size_t mark);
+
+	private:
+		static const size_t _block_size = 1 << 20;
+
+		std::vector< std::unique_ptr<char[]> > _blocks;
+		std::vector<size_t> _sizes;
+		std::vector<size_t> _starts;  // Position of each block's first byte
+		size_t _block;                // Current block
+		size_t _used;                 // Bytes used in current block
+	};
+
+	// Allocates from arena given, or from heap if none. Copies of containers using it
+	// get allocated from heap, containers copy assigned to keep their own allocator, so
+	// copies never point into an arena rewound along with their source. Moved and 
+	// swapped ones keep their arena.
 	template<typename _Type>
+	class ArenaAllocator
+	{
+	public:
+		typedef _Type value_type;
+		typedef std::false_type propagate_on_container_copy_assignment;
+		typedef std::true_type propagate_on_container_move_assignment;
+		typedef std::true_type propagate_on_container_swap;
+
+		Arena* arena;
+
+		ArenaAllocator() 
+			: arena(nullptr) 
+		{ }
+
+		ArenaAllocator(Arena* _arena) 
+			: arena(_arena) 
+		{ }
+
+		template<typename _Other> 
+		ArenaAllocator(const ArenaAllocator<_Other>& alloc) 
+			: arena(alloc.arena) 
+		{ }
+
+		_Type* allocate(const size_t n)
+		{
+			if (arena)
+				return static_cast<_Type*>(arena->Allocate(n * sizeof(_Type), alignof(_Type)));
+			return static_cast<_Type*>(::operator new(n * sizeof(_Type)));
+		}
+
+		void deallocate(_Type* p, const size_t /*n*/)
+		{
+			if (!arena)
+				::operator delete(p);
+		}
+
+		ArenaAllocator select_on_container_copy_construction() const
+		{
+			return ArenaAllocator();
+		}
+
+		template<typename _Other> 
+		bool operator==(const ArenaAllocator<_Other>& alloc) const { return arena == alloc.arena; }
+
+		template<typename _Other> 
+		bool operator!=(const ArenaAllocator<_Other>& alloc) const { return arena != alloc.arena; }
+	};
+
+
+	template<typename _Type, typename _Alloc = std::allocator<_Type> >
 	class Vector 
-		: public std::vector<_Type>
+		: public std::vector<_Type, _Alloc>
 	{
-		typedef std::vector<_Type> _base;
+		typedef std::vector<_Type, _Alloc> _base;
 
 	public:
 
+		Vector()
+		{ }
+
+		explicit Vector(const _Alloc& alloc)
+			: _base(alloc)
+		{ }
+
 		int distance(iterator start, iterator end) const
 		{
 			iterator::difference_type d = end - start;
@@ -75,6 +165,33 @@ namespace ImageTracer
 		: public Vector<int>
 	{ };
 
+	// Path coordinates, scratch data allocated from an arena if given one
+	class CoordList 
+		: public Vector<int, ArenaAllocator<int> >
+	{
+	public:
+		CoordList();
+		explicit CoordList(Arena* arena);
+	};
+
+	// Direction codes 0..8, -1 for none, scratch data allocated from an arena if given one
+	class CodeList 
+		: public Vector<signed char, ArenaAllocator<signed char> >
+	{
+	public:
+		CodeList();
+		explicit CodeList(Arena* arena);
+	};
+
+	// Path point indices used as stack, scratch data allocated from an arena if given one
+	class IndexStack 
+		: public Vector<int, ArenaAllocator<int> >
+	{
+	public:
+		IndexStack();
+		explicit IndexStack(Arena* arena);
+	};
+
 
 	class Point
 	{
@@ -125,14 +242,48 @@ namespace ImageTracer
 	};
 
 
+	class BBox
+	{
+	public:
+		int coords[4];
+
+		BBox();
+		BBox(const int l, const int t, const int r, const int b);
+		BBox(const BBox& bbox);
+
+		bool Includes(const BBox& childbbox) const;
+	};
+
+	
 	class Poly
 	{
 	public:
 		SegmentList Segments;
 
+		// Bounding box of the edge node path this polygon was traced from
+		BBox        BoundingBox;
+
+		// Hole polygons are cut out of their parent
+		bool        IsHole;
+
+		// Indices of hole polygons within same layer having this one as parent
+		IntList     HoleChildren;
+
+		// Path coordinates of the cell tracing started at, being the contour's first cell in
+		// raster order. Polygons of a layer are ordered by it.
+		int         StartX;
+		int         StartY;
+
 		Poly();
 		Poly(const Poly& poly);
+		Poly(Poly&& poly) noexcept;
 		Poly(const SegmentList& segments);
+		Poly(const SegmentList& segments, const BBox& bbox, const bool hole, const IntList& holechildren);
+		Poly(SegmentList&& segments, const BBox& bbox, const bool hole, IntList&& holechildren);
+		Poly(SegmentList&& segments, const BBox& bbox, const bool hole, IntList&& holechildren, const int startx, const int starty);
+
+		Poly& operator=(const Poly& poly);
+		Poly& operator=(Poly&& poly) noexcept;
 	};
 
 	class PolyList 
@@ -148,7 +299,12 @@ namespace ImageTracer
 
 		Layer();
 		Layer(const Layer& layer);
+		Layer(Layer&& layer) noexcept;
 		Layer(const PolyList& polys, const int color_index);
+		Layer(PolyList&& polys, const int color_index);
+
+		Layer& operator=(const Layer& layer);
+		Layer& operator=(Layer&& layer) noexcept;
 	};
 
 	class LayerList 
@@ -156,38 +312,305 @@ namespace ImageTracer
 	{ };
 
 
-	class BBox
+	// Layers traced, stored in flat arrays for handing them over w/o walking nested lists.
+	// Items of each level are stored one after another, offset tables have one entry more 
+	// than items: Item i spans [offsets[i], offsets[i + 1]) of next level's items.
+	class FlatResult
 	{
 	public:
-		int coords[4];
+		// Per layer: color index, offsets into polys
+		IntList     LayerColors;
+		IntList     LayerOffsets;
+
+		// Per poly: offsets into segments, hole flag (0 or 1), bounding box (4 ints),
+		// offsets into hole children. Hole children are poly indices within same layer.
+		IntList     PolyOffsets;
+		IntList     PolyHoles;
+		IntList     PolyBBoxes;
+		IntList     HoleOffsets;
+		IntList     HoleChildren;
+
+		// Segments of all polys
+		SegmentList Segments;
 
-		BBox();
-		BBox(const int l, const int t, const int r, const int b);
-		BBox(const BBox& bbox);
+		// Without any layers, offset tables only hold their first entry
+		FlatResult();
+		explicit FlatResult(const LayerList& layers);
+	};
 
-		bool Includes(const BBox& childbbox) const;
+
+	// Storage of polygons no longer needed, handed out again for new ones so their 
+	// segments and hole children don't need to be allocated again. Lists given back 
+	// last are handed out first, in same order as polygons given. Not thread safe.
+	class PolyPool
+	{
+	public:
+		// Keeps storage of polys given, releasing anything left from previous ones
+		void Give(PolyList& polys);
+
+		// Makes room for storage of up to count polys, so giving them doesn't allocate
+		void Reserve(const size_t count);
+
+		// Empty list given gets spare storage, if any
+		void Take(PolyList& polys);
+		void Take(SegmentList& segments);
+		void Take(IntList& children);
+
+	private:
+		PolyList                 _polys;
+		std::vector<SegmentList> _segments;
+		std::vector<IntList>     _children;
 	};
 
-	
+
+	class EdgeNode
+	{
+	public:
+		int  index;
+		byte type;
+
+		EdgeNode();
+		EdgeNode(const int _index, const byte _type);
+	};
+
+	class EdgeNodeList 
+		: public Vector<EdgeNode>
+	{ };
+
+
+	// Path points are stored as separate x and y arrays in half units (2 * coordinate):
+	// Pathscan yields integer coordinates and internodes are midpoints between them, 
+	// so points are exact and only converted to float for fitting and output.
+	// Direction codes in linesegments belong to interpolated paths only, paths straight 
+	// from pathscan don't have any. Points and codes of paths created with an arena are 
+	// allocated from it.
 	class Path
 	{
 	public:
-		PointList   points;
-		IntList     linesegments;
+		CoordList   xs;
+		CoordList   ys;
+		CodeList    linesegments;
 		BBox        boundingbox;
 		bool        isholepath;
-	//TODO: IntList     holechildren;
+		IntList     holechildren;
 		SegmentList segments;
+		int         startx;      // First point, kept after points are released
+		int         starty;
 
 		Path();
+		explicit Path(Arena* arena);
 		Path(const Path& p);
+		Path(Path&& p) noexcept;
+
+		Path& operator=(const Path& p);
+		Path& operator=(Path&& p) noexcept;
+
+		int   PointCount() const;
+		Point PointAt(const int i) const;
+		void  AddPoint(const int x2, const int y2);
+		void  ReservePoints(const int count);
+
+		// Number of points from start to end, wrapping around
+		int   Distance(const int start, const int end) const;
+
+		// Index n points after start, wrapping around
+		int   Next(const int start, const int n = 1) const;
 	};
 
+	// Paths of a layer, allocated from an arena if given one
 	class PathList
-		: public Vector<Path>
+		: public Vector<Path, ArenaAllocator<Path> >
+	{
+	public:
+		PathList();
+		explicit PathList(Arena* arena);
+	};
+
+
+	// Uniform grid over an area, indexing bounding boxes by the grid cells they overlap.
+	// Cell lists are chained through a single list of entries, so adding to them only
+	// allocates when that one runs out of room.
+	class BBoxGrid
+	{
+		class Entry
+		{
+		public:
+			int index;
+			int next;
+		};
+
+	public:
+		// Indices of bounding boxes listed by a cell, in order added
+		class CandidateList
+		{
+		public:
+			class const_iterator
+			{
+			public:
+				const_iterator(const std::vector<Entry>& entries, const int entry);
+
+				int  operator*() const;
+				bool operator!=(const const_iterator& other) const;
+				const_iterator& operator++();
+
+			private:
+				const std::vector<Entry>* _entries;
+				int                       _entry;
+			};
+
+			CandidateList(const std::vector<Entry>& entries, const int first);
+
+			const_iterator begin() const;
+			const_iterator end() const;
+
+		private:
+			const std::vector<Entry>& _entries;
+			int                       _first;
+		};
+
+		BBoxGrid();
+		BBoxGrid(const BBox& area);
+
+		// Clears grid and sets it up for area given, keeping storage of its cells
+		void Reset(const BBox& area);
+
+		void Add(const int index, const BBox& bbox);
+
+		// Indices of all bounding boxes which might contain point (x, y), in order added
+		CandidateList Candidates(const int x, const int y) const;
+
+	private:
+		BBox               _area;
+		int                _cellsize;
+		int                _cols;
+		int                _rows;
+		std::vector<int>   _heads;      // First and last entry of each cell, -1 if empty
+		std::vector<int>   _tails;
+		std::vector<Entry> _entries;
+
+		int _Col(const int x) const;
+		int _Row(const int y) const;
+	};
+
+
+	class Cell
+	{
+	public:
+		int x, y;
+
+		Cell();
+		Cell(const int _x, const int _y);
+
+		// Raster order
+		bool operator<(const Cell& cell) const;
+	};
+
+	class CellList
+		: public Vector<Cell>
 	{ };
 
 
+	// Part of a contour within a horizontal stripe of an edge node array, cells 
+	// being in bordered coordinates. Open fragments start and end where the contour 
+	// crosses the stripe's top or bottom border, closed ones are complete contours 
+	// starting with their first cell in raster order.
+	class PathFragment
+	{
+	public:
+		CellList  cells;
+		long long ends[2];   // Crossings at start and end (row below crossing * width + column), -1 if closed
+		int       first;     // Position of first cell in raster order
+		byte      firsttype; // Edge node type of first cell
+
+		PathFragment();
+
+		bool IsClosed() const;
+	};
+
+	class PathFragmentList
+		: public Vector<PathFragment>
+	{ };
+
+
+	// Joins open fragments at their crossings into closed ones
+	class PathStitcher
+	{
+	public:
+		// Adds an open fragment, returns true if this closed a contour which is
+		// then returned in closed
+		bool Add(PathFragment&& fragment, PathFragment& closed);
+
+		// Number of fragments still waiting for their counterparts
+		int Pending() const;
+
+	private:
+		// Chain of fragments, each one referenced by its index * 2 + reversed
+		class Chain
+		{
+		public:
+			std::deque<int> parts;
+			long long       ends[2];
+
+			void Reverse();
+		};
+
+		std::vector<PathFragment> _fragments;
+		std::vector<int>          _freefragments;
+		std::vector<Chain>        _chains;
+		std::vector<int>          _freechains;
+
+		// Open crossings -> chain waiting at that crossing
+		std::unordered_map<long long, int> _open;
+
+		int  _Join(const int chain1, const int chain2, const long long crossing);
+		void _Close(const int chain, PathFragment& closed);
+	};
+
+
+	// Instruction sets kernels are written for
+	enum KernelSet
+	{
+		KernelSet_Scalar,
+		KernelSet_SSE2,
+		KernelSet_AVX2,
+		KernelSet_Count
+	};
+
+	// Kernels of layering and fitting steps. Tracing always uses those of best instruction
+	// set supported, others are exposed so tests can check all of them yield same results.
+	class Kernels
+	{
+	public:
+		// Stores offsets of windows in [start, count) not made of a single color index, 
+		// window k being above[k], above[k+1], below[k] and below[k+1]. Returns their number.
+		typedef int (*ScanWindowsFunc)(const byte* above, const byte* below, const int start, const int count, int* offsets);
+
+		// Compares points xs/ys[k] (half units), being points i0 + k of a sequence, to line
+		// start + v * i or to spline through start, control point c and end at i / tl.
+		// Returns true if any squared distance exceeds threshold. Line kernels also update
+		// errorval and errorindex with first point having largest distance above errorval.
+		typedef bool (*LineErrorsFunc)(const int* xs, const int* ys, const int count, const int i0, const float sx, const float sy, const float vx, const float vy, const float threshold, float& errorval, int& errorindex);
+		typedef bool (*SplineErrorsFunc)(const int* xs, const int* ys, const int count, const int i0, const float tl, const float sx, const float sy, const float cx, const float cy, const float ex, const float ey, const float threshold);
+
+		// Whether CPU supports instruction set given
+		static bool Supported(const KernelSet set);
+
+		// Best instruction set supported by CPU
+		static KernelSet Best();
+
+		// Kernels written for instruction set given, falling back to those of next lower one
+		// if there are none. Only to be called if it's supported.
+		static ScanWindowsFunc  ScanWindows(const KernelSet set);
+		static LineErrorsFunc   LineErrors(const KernelSet set);
+		static SplineErrorsFunc SplineErrors(const KernelSet set);
+	};
+
+
+	// Version of traced results, to be increased whenever tracing yields different results
+	// for same input. Results kept across runs (see TraceCache) are only used if it matches.
+	const unsigned int TraceResultVersion = 1;
+
+
 	class Options
 	{
 	public:
@@ -223,7 +646,7 @@ namespace ImageTracer
 		// Layering method
 		//
 		//layering : 0,
-		//=> Only sequencial layering for now
+		//=> Single pass over all color indices, yields same edge nodes as sequencial layering
 
 
 		// SVG rendering
@@ -268,19 +691,169 @@ namespace ImageTracer
 	};
 
 
+	// Color-indexed image data to be traced in a batch
+	class BatchImage
+	{
+	public:
+		byte* Pixels;
+		int   Width;
+		int   Height;
+
+		BatchImage();
+		BatchImage(byte* pixels, const int width, const int height);
+	};
+
+	class BatchImageList
+		: public Vector<BatchImage>
+	{ };
+
+
+	// Statistics of a trace. Results of TraceBatch all get those of the whole batch,
+	// threads and load balance then describe tracing layers of all images together.
+	class TraceStats
+	{
+	public:
+		// Number of threads layers were traced with, 1 if paths were traced in parallel
+		int Threads;
+
+		// Total busy time of all threads relative to all of them being busy as long as 
+		// the longest one, 1 = perfectly balanced. Paths traced in parallel aren't
+		// measured, this is negative then.
+		double LoadBalance;
+
+		// Whether layers were traced one after another with their paths being traced
+		// in parallel
+		bool ParallelPaths;
+
+		// Layers and polygons taken over from previous results when retracing, 
+		// 0 if all of them were traced
+		int LayersReused;
+		int PolysReused;
+
+		TraceStats();
+	};
+
+
 	class ImageTracer
 	{
 	public:
 		// Actual layers traced from input
 		LayerList Layers;
 
+		// Statistics gathered while tracing
+		TraceStats Stats;
+
 		// Traces color-indexed image data
 		static ImageTracer* Trace(byte* pixels, const int width, const int height, const Options& options);
 
+		// Same as above, but results are returned in flat arrays
+		static FlatResult* TraceFlat(byte* pixels, const int width, const int height, const Options& options);
+
+		// Source of image rows for streamed tracing: Stores up to count rows to buffer given,
+		// returns number of rows stored, 0 at end of image.
+		typedef std::function<int(byte* rows, const int count)> RowSource;
+
+		// Receives polygons of streamed tracing along with their color index
+		typedef std::function<void(const int color_index, Poly& poly)> PolySink;
+
+		// Traces color-indexed image data too large to be held in memory at once. Rows are 
+		// pulled from source in bands of up to bandrows rows, only the current band and the 
+		// contours still open are kept. Polygons are passed to sink as soon as their contour 
+		// is closed, so they are in no particular order. Returns false if tracing failed, 
+		// images Trace rejects (single color, color index 255 used) are rejected as well.
+		// Failures only show up with the band causing them, polygons passed to sink before 
+		// aren't taken back: Color index 255 in a later band leaves sink with the polygons of 
+		// earlier bands, which have to be discarded. Single color images pass nothing to sink,
+		// their only contour being closed by bottom border.
+		// Polygons tell whether they're holes, but don't get any hole children: A hole's 
+		// parent might only be closed after the hole was passed to sink.
+		static bool TraceStream(const int width, const RowSource& source, const PolySink& sink, const Options& options, const int bandrows = 64);
+
+		// Traces color-indexed image data again after pixels within dirty (inclusive pixel 
+		// coordinates) changed, previous being traced from same sized image with same options.
+		// Only contours touching dirty pixels are traced again, all others are taken over from 
+		// previous. Results are same as tracing all of the image again.
+		static ImageTracer* Retrace(const ImageTracer& previous, byte* pixels, const int width, const int height, const BBox& dirty, const Options& options);
+
+		// Traces many color-indexed images at once, results being in same order as images.
+		// Layers of all images are scheduled together on one pool of threads, each layer 
+		// being traced by a single thread, so small images don't need a parallel region 
+		// of their own. Caller owns results, images failed to trace get nullptr.
+		// Statistics of all results are those of the whole batch.
+		// All images are layered before any layer is traced, so edge nodes of every image
+		// are held at once: Peak memory grows with total pixels of the batch, not with
+		// number of threads. Split batches of large images to bound it.
+		static std::vector<ImageTracer*> TraceBatch(const BatchImageList& images, const Options& options);
+
 	private:
+		friend class TracerContext;
+
 		ImageTracer();
 
-		void _Trace(byte* pixels, const int width, const int height, const Options& options);
+		// Scratch memory, one arena per thread
+		std::vector<Arena> _arenas;
+
+		// Index of non-hole paths for pathscan, one per thread
+		std::vector<BBoxGrid> _grids;
+
+		// Segments of the path being fitted, one list per thread
+		std::vector<SegmentList> _fitted;
+
+		// Storage kept from previous results, one pool per color index
+		std::vector<PolyPool> _pools;
+
+		// Edge nodes per color index and busy time per thread, kept for reuse
+		std::vector<EdgeNodeList> _edgenodes;
+		std::vector<double>       _busy;
+
+		// Estimated cost of layers dealt to each thread, kept for reuse
+		std::vector<size_t> _load;
+
+		// Sequences of the path being fitted and their segments when fitting them in parallel,
+		// only used by calling thread and kept for reuse
+		std::vector< std::pair<int, int> > _sequences;
+		std::vector<SegmentList>           _seqsegments;
+
+		// Arena, grid and fitted segments of the calling thread
+		Arena&       _Arena();
+		BBoxGrid&    _Grid();
+		SegmentList& _Fitted();
+
+		// Frees all memory kept for reuse, only results are kept
+		void _Release();
+
+		// Makes room in pools for storage of current results, so next call can take
+		// it over w/o allocating
+		void _ReservePools();
+
+		// Layers are appended to flat instead if given one, leaving Layers empty
+		void _Trace(byte* pixels, const int width, const int height, const Options& options, FlatResult* flat = nullptr);
+
+		void _TraceStream(const int width, const RowSource& source, const PolySink& sink, const Options& options, const int bandrows);
+
+		// Traces a single closed contour and passes its polygon to sink, unless it's shorter than pathomit
+		void _TraceContour(const PathFragment& contour, const int color_index, const PolySink& sink, const Options& options);
+
+		// Traces a single color layer, given its edge nodes and bounding box within image:
+		// pathscan -> internodes -> batchtracepaths
+		// Storage of new polygons is taken from pool given.
+		PolyList _TraceLayer(const EdgeNodeList& edgenodes, const BBox& colorbbox, const int width, const int height, const Options& options, const bool parallel, PolyPool& pool);
+
+		// Same as above, but layer is appended to flat with color index given. Paths traced 
+		// as soon as they're closed have their segments written to flat right away.
+		void _TraceLayer(const EdgeNodeList& edgenodes, const BBox& colorbbox, const int width, const int height, const Options& options, const bool parallel, PolyPool& pool, const int color_index, FlatResult& flat);
+
+		// Scans and traces paths of a single color layer for both of the above, flat being
+		// passed on to pathscan
+		PathList _TraceLayerPaths(const EdgeNodeList& edgenodes, const BBox& colorbbox, const int width, const int height, const Options& options, const bool parallel, PolyPool& pool, FlatResult* flat);
+
+		// Replaces layers traced before by those of image data changed within dirty pixels
+		void _Retrace(byte* pixels, const int width, const int height, const BBox& dirty, const Options& options);
+
+		// Traces contours of a single color layer touching dirty cells (path coordinates) again, 
+		// given its edge nodes around them. Area (bordered coordinates) needs to include all
+		// of these contours.
+		PolyList _RetraceLayer(const EdgeNodeList& edgenodes, const BBox& area, const BBox& dirtycells, const int width, const Options& options, PolyPool& pool);
 
 		// 1. Color quantization
 		// Using a form of k-means clustering repeatead options.colorquantcycles times. http://en.wikipedia.org/wiki/Color_quantization
@@ -294,18 +867,70 @@ namespace ImageTracer
 		//
 		// 48  ░░  ░░  ░░  ░░  ░▓  ░▓  ░▓  ░▓  ▓░  ▓░  ▓░  ▓░  ▓▓  ▓▓  ▓▓  ▓▓
 		//     0   1   2   3   4   5   6   7   8   9   10  11  12  13  14  15
-		void _LayeringStep(byte* pixels, const int width, const int height, const byte color_index, int* layer);
+		//
+		// Single pass over all color indices: Each 2x2 window touches at most four different
+		// colors, so only those get an edge node. Nodes of type 0 and 15 are not stored, 
+		// resulting node lists are per color and ordered by index.
+		// Pixels are read in place, the 1px border (color index 255) around them is virtual 
+		// and node indices are based on this bordered image. Also builds a histogram and
+		// bounding box for every color index.
+		void _LayeringStep(byte* pixels, const int width, const int height, EdgeNodeList* edgenodes, int* histogram, BBox* colorbboxes);
+
+		// Edge nodes of bordered row j, above and below being the image rows around it
+		// (or a row of color index 255 outside of image). Offsets is scratch space for width ints.
+		void _LayeringRow(const byte* above, const byte* below, const int width, const int j, int* offsets, EdgeNodeList* edgenodes);
 
 		// 3. Walking through an edge node array, discarding edge node types 0 and 15 and creating paths from the rest.
 		// Walk directions (dir): 0 > ; 1 ^ ; 2 < ; 3 v 
-		PathList _PathScan(int* layer, const int width, const int height, const int pathomit);
+		// Only the cells listed in edgenodes are checked for new paths.
+		// Layer array only covers given area (inclusive cell coordinates) of the full width x height edge node array.
+		// If fused, each path is interpolated and traced (4. and 5.) as soon as it's closed, keeping only its segments.
+		// Segments and hole children get their storage from pool given. If fused and given flat, 
+		// segments are appended to flat's ones instead, along with the offset of each path's end.
+		PathList _PathScan(byte* layer, const EdgeNodeList& edgenodes, const BBox& area, const int width, const int height, const Options& options, const bool fused, PolyPool& pool, FlatResult* flat = nullptr);
+
+		// 3. Same as above, but layer is split into horizontal stripes scanned in parallel. Contour fragments 
+		// crossing stripe borders are stitched afterwards, resulting paths are same as with _PathScan.
+		// Layer is not modified.
+		PathList _PathScanStripes(const byte* layer, const EdgeNodeList& edgenodes, const BBox& area, const int width, const int height, const int pathomit, const int stripes, PolyPool& pool);
+
+		// Walks all contours and contour fragments within rows [row0, row1) of layer, 
+		// edgenodes given must be those within these rows.
+		void _ScanStripe(const byte* layer, EdgeNodeList::const_iterator first, EdgeNodeList::const_iterator last, const BBox& area, const int width, const int row0, const int row1, PathFragmentList& fragments);
+
+		// Creates path from a closed fragment
+		void _FragmentToPath(const PathFragment& fragment, Path& path);
+
+		// Walks a single cell of type given entered in direction dir: Turns and moves x, y on to 
+		// next cell. Returns type left behind in the cell walked, or -1 if it can't be entered 
+		// in direction dir, leaving dir, x and y unchanged then.
+		int _WalkStep(const int type, int& dir, int& x, int& y) const;
+
+		// Keeps path just closed at end of paths unless it's shorter than pathomit. Holes are added 
+		// to the children of their parent shape, being the innermost non-hole path found before them 
+		// whose bounding box includes the hole's one. Outers indexes all non-hole paths found so far, 
+		// others are added to it. Returns whether path was kept.
+		bool _AddPath(PathList& paths, const int pathomit, BBoxGrid& outers, const int width, const int height, PolyPool& pool);
+
+		// 3. Same as _PathScan for a layer only covering area around dirty cells, keeping only contours 
+		// touching those, traced as soon as they're closed. Contours leaving area are dropped when 
+		// reaching its border or a cell already walked, so they're never followed outside of layer.
+		PathList _PathScanDirty(byte* layer, const EdgeNodeList& edgenodes, const BBox& area, const BBox& dirtycells, const int width, const Options& options, PolyPool& pool);
+
+		// Sets hole children of all polygons of a layer same as pathscan does, polygons
+		// being in order traced
+		void _LinkHoles(PolyList& polys, const int width, const int height, PolyPool& pool);
 
 		// 4. interpollating between path points for nodes with 8 directions ( East, SouthEast, S, SW, W, NW, N, NE )
-		PathList _InterNodes(const PathList& paths, const Options& options);
+		// Paths are processed in parallel if requested.
+		PathList _InterNodes(const PathList& paths, const Options& options, const bool parallel);
+
+		// 4. for a single path
+		void _InterNodePath(const Path& path, const Options& options, Path& ins);
 
 		bool _TestRightAngle(const Path& path, const int idx1, const int idx2, const int idx3, const int idx4, const int idx5) const;
 
-		int _GetDirection(const Point& pt1, const Point& pt2) const;
+		int _GetDirection(const int x1, const int y1, const int x2, const int y2) const;
 
 		// 5. tracepath() : recursively trying to fit straight and quadratic spline segments on the 8 direction internode path
 		//
@@ -315,19 +940,40 @@ namespace ImageTracer
 		// 5.4. Fit a quadratic spline through errorpoint (project this to get controlpoint), then measure errors on every point in the sequence
 		// 5.5. If the spline fails (distance error > qtres), find the point with the biggest error, set splitpoint = fitting point
 		// 5.6. Split sequence and recursively apply 5.2. - 5.6. to startpoint-splitpoint and splitpoint-endpoint sequences
-		Path _TracePath(const Path& path, const float ltres, const float qtres);
+		//
+		// Sequences found are fitted in parallel if requested, which only one thread may do at a time. 
+		// Segments traced are appended to segments given.
+		void _TracePath(const Path& path, const float ltres, const float qtres, const bool parallel, SegmentList& segments);
+
+		// 5.2. - 5.6. fitting straight or quadratic line segments on this sequence of path nodes, splitting
+		// it until every part fits, called from tracepath(). Segments fitted are appended to segments given.
+		// Parts still to be fitted are kept on an explicit stack instead of recursing.
+		void _FitSeq(const Path& path, const float ltres, const float qtres, const int seqstart, const int seqend, SegmentList& segments);
 
-		// 5.2. - 5.6. recursively fitting a straight or quadratic line segment on this sequence of path nodes,
-		// called from tracepath()
-		SegmentList _FitSeq(const Path& path, const float ltres, const float qtres, PointList::const_iterator seqstart, PointList::const_iterator seqend);
+		// 5.2. - 5.5. for a single part: Appends segment and returns -1 if one fits, 
+		// otherwise returns the point to split at.
+		int _FitSegment(const Path& path, const float ltres, const float qtres, const int seqstart, const int seqend, SegmentList& segments);
 
 		// 5. Batch tracing paths
-		PathList _BatchTracePaths(const PathList& internodepaths, const float ltres, const float qtres);
+		// If parallel is requested, either paths are traced in parallel or, if there are 
+		// too few of them, sequences within each path are fitted in parallel.
+		// Resulting paths only hold segments, their storage is taken from pool given.
+		PathList _BatchTracePaths(const PathList& internodepaths, const float ltres, const float qtres, const bool parallel, PolyPool& pool);
 
+		// 4. and 5. for a single path straight from pathscan, releasing its points. 
+		// Segments traced are appended to segments given.
+		void _TraceClosedPath(Path& path, const Options& options, SegmentList& segments);
+
+
+		// Stripe parallel pathscan is used for layers with at least this many edge nodes,
+		// and with each stripe having at least this many rows
+		const int _stripescan_min_nodes = 65536;
+		const int _stripescan_min_rows  = 16;
 
 		// Lookup tables for pathscan
 		// pathscan_combined_lookup[ arr[py][px] ][ dir ] = [nextarrpypx, nextdir, deltapx, deltapy];
-		const int _pathscan_combined_lookup[16][4][4] = {
+		// All values fit into a signed byte, same as the edge node types in layer array
+		const signed char _pathscan_combined_lookup[16][4][4] = {
 			{{-1,-1,-1,-1}, {-1,-1,-1,-1}, {-1,-1,-1,-1}, {-1,-1,-1,-1}},// arr[py,px]===0 is invalid
 			{{ 0, 1, 0,-1}, {-1,-1,-1,-1}, {-1,-1,-1,-1}, { 0, 2,-1, 0}},
 			{{-1,-1,-1,-1}, {-1,-1,-1,-1}, { 0, 1, 0,-1}, { 0, 0, 1, 0}},
@@ -359,4 +1005,83 @@ namespace ImageTracer
 
 	};
 
+
+	// Long-lived tracer for many images: Keeps its scratch memory and the storage of its
+	// previous results, so tracing same image again doesn't allocate, same goes for images
+	// of same size and similar content once warmed up. Scratch memory is kept per thread,
+	// with layers and paths dealt to threads the same way for same image, so this holds 
+	// for any number of threads and for paths traced in parallel (see TraceStats::ParallelPaths).
+	// Only layers large enough to have their pathscan split into stripes allocate, their 
+	// contour fragments being created anew. Not thread safe, use one context per thread.
+	class TracerContext
+	{
+	public:
+		TracerContext();
+
+		// Traces color-indexed image data, returns nullptr if tracing failed.
+		// Results are owned by context and valid until next call.
+		const ImageTracer* Trace(byte* pixels, const int width, const int height, const Options& options);
+
+		// Same as ImageTracer::Retrace, updating results of previous call in place. 
+		// Traces all of the image if there are none.
+		const ImageTracer* Retrace(byte* pixels, const int width, const int height, const BBox& dirty, const Options& options);
+
+	private:
+		ImageTracer _tracer;
+	};
+
+
+	class FrameStats
+	{
+	public:
+		// Bounding box of pixels changed since previous frame, all -1 if none
+		BBox ChangedArea;
+
+		// Whether frame was traced from scratch instead of retracing changed area
+		bool FullTrace;
+
+		// Layers and polygons of frame, and how many of them were taken over from previous frame
+		int Layers;
+		int LayersReused;
+		int Polys;
+		int PolysReused;
+
+		FrameStats();
+	};
+
+
+	// Tracer for sequences of frames, such as video or animation, where most pixels stay 
+	// same from one frame to the next: Each frame is compared to the previous one, layers 
+	// without changes are taken over as they are and only contours touching changed pixels
+	// get traced again. Frames of another size or with other options are traced from scratch.
+	// Not thread safe, use one tracer per sequence.
+	class SequenceTracer
+	{
+	public:
+		// Statistics of last frame traced
+		FrameStats Stats;
+
+		SequenceTracer();
+
+		// Traces next frame of sequence, returns nullptr if tracing failed.
+		// Results are owned by tracer and valid until next call.
+		const ImageTracer* TraceFrame(byte* pixels, const int width, const int height, const Options& options);
+
+		// Forgets previous frame, so next one gets traced from scratch
+		void Reset();
+
+	private:
+		TracerContext     _context;
+		std::vector<byte> _previous;
+		int               _width;
+		int               _height;
+		Options           _options;
+
+		// Frames with changes spanning more than this share of their area are traced from scratch
+		const double _retrace_max_area = 0.5;
+
+		// Bounding box of pixels differing from previous frame, returns false if there are none
+		bool _ChangedArea(const byte* pixels, BBox& area) const;
+	};
+
 };
@@ -0,0 +1,139 @@
+// ImageTracerC.cpp
+//
+
+#include "stdafx.h"
+#include <stddef.h>
+
+#include "ImageTracer.h"
+
+#define IMAGETRACER_C_EXPORTS
+#include "ImageTracerC.h"
+
+
+// Plain C interface, results are handed out w/o copying them
+
+// Segments are handed out as they are, so both layouts need to match
+static_assert(sizeof(ImageTracer::Segment) == sizeof(it_segment), "Segment layout mismatch");
+static_assert(sizeof(ImageTracer::Segment::Type) == sizeof(int), "Segment layout mismatch");
+static_assert(offsetof(ImageTracer::Segment, type) == offsetof(it_segment, type), "Segment layout mismatch");
+static_assert(offsetof(ImageTracer::Segment, x1) == offsetof(it_segment, x1), "Segment layout mismatch");
+static_assert(offsetof(ImageTracer::Segment, y3) == offsetof(it_segment, y3), "Segment layout mismatch");
+static_assert(ImageTracer::Segment::Type_Line == IT_SEGMENT_LINE, "Segment type mismatch");
+static_assert(ImageTracer::Segment::Type_QuadSpline == IT_SEGMENT_QUADSPLINE, "Segment type mismatch");
+
+
+struct it_result
+{
+	ImageTracer::FlatResult* flat;
+};
+
+
+//*****************************************************************************
+
+void it_options_default(it_options* options)
+{
+	if (!options)
+		return;
+
+	ImageTracer::Options opt;
+	options->ltres = opt.ltres;
+	options->qtres = opt.qtres;
+	options->pathomit = opt.pathomit;
+	options->rightangleenhance = opt.rightangleenhance ? 1 : 0;
+}
+
+it_result* it_trace(const unsigned char* pixels, int width, int height, const it_options* options)
+{
+	if (!pixels || (width <= 0) || (height <= 0))
+		return nullptr;
+
+	ImageTracer::Options opt;
+	if (options)
+	{
+		opt.ltres = options->ltres;
+		opt.qtres = options->qtres;
+		opt.pathomit = options->pathomit;
+		opt.rightangleenhance = (options->rightangleenhance != 0);
+	}
+
+	// Pixels are only read
+	ImageTracer::FlatResult* flat = ImageTracer::ImageTracer::TraceFlat(const_cast<byte*>(pixels), width, height, opt);
+	if (!flat)
+		return nullptr;
+
+	it_result* result = new (std::nothrow) it_result;
+	if (!result)
+	{
+		delete flat;
+		return nullptr;
+	}
+	result->flat = flat;
+	return result;
+}
+
+void it_free(it_result* result)
+{
+	if (!result)
+		return;
+
+	delete result->flat;
+	delete result;
+}
+
+
+//*****************************************************************************
+
+int it_result_layer_count(const it_result* result)
+{
+	return result ? (int)result->flat->LayerColors.size() : 0;
+}
+
+const int* it_result_layer_colors(const it_result* result)
+{
+	return result ? result->flat->LayerColors.data() : nullptr;
+}
+
+const int* it_result_layer_offsets(const it_result* result)
+{
+	return result ? result->flat->LayerOffsets.data() : nullptr;
+}
+
+int it_result_poly_count(const it_result* result)
+{
+	return result ? (int)result->flat->PolyHoles.size() : 0;
+}
+
+const int* it_result_poly_offsets(const it_result* result)
+{
+	return result ? result->flat->PolyOffsets.data() : nullptr;
+}
+
+const int* it_result_poly_holes(const it_result* result)
+{
+	return result ? result->flat->PolyHoles.data() : nullptr;
+}
+
+const int* it_result_poly_bboxes(const it_result* result)
+{
+	return result ? result->flat->PolyBBoxes.data() : nullptr;
+}
+
+const int* it_result_hole_offsets(const it_result* result)
+{
+	return result ? result->flat->HoleOffsets.data() : nullptr;
+}
+
+const int* it_result_hole_children(const it_result* result)
+{
+	return result ? result->flat->HoleChildren.data() : nullptr;
+}
+
+int it_result_segment_count(const it_result* result)
+{
+	return result ? (int)result->flat->Segments.size() : 0;
+}
+
+const it_segment* it_result_segments(const it_result* result)
+{
+	return result ? reinterpret_cast<const it_segment*>(result->flat->Segments.data()) : nullptr;
+}
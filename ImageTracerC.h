@@ -0,0 +1,83 @@
+// ImageTracerC.h
+//
+// Plain C interface to ImageTracer, for use from other languages and runtimes.
+// Exported by ImageTracerC.dll, which is native code only and doesn't load the CLR.
+// Results are stored in flat arrays owned by the result handle, all pointers handed
+// out stay valid until it_free() is called on it.
+
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef IMAGETRACER_C_EXPORTS
+#define IT_API __declspec(dllexport)
+#else
+#define IT_API __declspec(dllimport)
+#endif
+
+
+// Segment types
+#define IT_SEGMENT_LINE       0
+#define IT_SEGMENT_QUADSPLINE 1
+
+// Segment traced, lines only use (x1, y1) and (x2, y2)
+typedef struct it_segment
+{
+	int   type;
+	float x1, y1, x2, y2, x3, y3;
+} it_segment;
+
+// Tracing options, see ImageTracer::Options
+typedef struct it_options
+{
+	float ltres;
+	float qtres;
+	int   pathomit;
+	int   rightangleenhance;
+} it_options;
+
+// Opaque result handle
+typedef struct it_result it_result;
+
+
+// Fills options given with defaults
+IT_API void it_options_default(it_options* options);
+
+// Traces width x height color-indexed pixels, options may be NULL to use defaults.
+// Returns NULL if tracing failed.
+IT_API it_result* it_trace(const unsigned char* pixels, int width, int height, const it_options* options);
+
+// Releases result and all arrays handed out for it
+IT_API void it_free(it_result* result);
+
+
+// Items of each level are stored one after another, offset tables have one entry more
+// than items: Item i spans [offsets[i], offsets[i + 1]) of next level's items.
+
+// Layers: color index and offsets into polys
+IT_API int        it_result_layer_count(const it_result* result);
+IT_API const int* it_result_layer_colors(const it_result* result);
+IT_API const int* it_result_layer_offsets(const it_result* result);
+
+// Polys: offsets into segments, hole flag (0 or 1), bounding box (4 ints: left, top,
+// right, bottom) and offsets into hole children
+IT_API int        it_result_poly_count(const it_result* result);
+IT_API const int* it_result_poly_offsets(const it_result* result);
+IT_API const int* it_result_poly_holes(const it_result* result);
+IT_API const int* it_result_poly_bboxes(const it_result* result);
+IT_API const int* it_result_hole_offsets(const it_result* result);
+
+// Hole children of all polys, being poly indices within same layer (0 is layer's first poly)
+IT_API const int* it_result_hole_children(const it_result* result);
+
+// Segments of all polys
+IT_API int               it_result_segment_count(const it_result* result);
+IT_API const it_segment* it_result_segments(const it_result* result);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,323 @@
+// ImageTracerCache.cpp
+//
+
+#include "stdafx.h"
+#include <limits.h>
+
+#include "ImageTracerCache.h"
+#include "ImageTracerFile.h"
+
+
+namespace ImageTracer
+{
+
+// Content-addressed cache of trace results
+
+
+CacheStats::CacheStats()
+	: Hits(0)
+	, DiskHits(0)
+	, Misses(0)
+	, Evictions(0)
+{ }
+
+
+//*****************************************************************************
+
+// 64-bit hash of pixel data, four independent lanes over 32 bytes at a time so it
+// runs at about memory speed. Compiled as native code, results don't depend on it.
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+static const unsigned long long _hash_prime1 = 0x9E3779B185EBCA87ULL;
+static const unsigned long long _hash_prime2 = 0xC2B2AE3D27D4EB4FULL;
+static const unsigned long long _hash_prime3 = 0x165667B19E3779F9ULL;
+static const unsigned long long _hash_prime4 = 0x85EBCA77C2B2AE63ULL;
+
+static inline unsigned long long _Rotate(const unsigned long long v, const int bits)
+{
+	return (v << bits) | (v >> (64 - bits));
+}
+
+static inline unsigned long long _Read64(const byte* data)
+{
+	unsigned long long v;
+	memcpy(&v, data, sizeof(v));
+	return v;
+}
+
+static inline unsigned long long _Round(unsigned long long acc, const unsigned long long v)
+{
+	acc += v * _hash_prime2;
+	acc = _Rotate(acc, 31);
+	return acc * _hash_prime1;
+}
+
+static inline unsigned long long _Merge(unsigned long long hash, const unsigned long long acc)
+{
+	hash ^= _Round(0, acc);
+	return hash * _hash_prime1 + _hash_prime4;
+}
+
+static unsigned long long _HashBytes(const byte* data, const size_t size, const unsigned long long seed)
+{
+	const byte* end = data + size;
+	unsigned long long hash;
+
+	if (size >= 32)
+	{
+		unsigned long long acc1 = seed + _hash_prime1 + _hash_prime2;
+		unsigned long long acc2 = seed + _hash_prime2;
+		unsigned long long acc3 = seed;
+		unsigned long long acc4 = seed - _hash_prime1;
+		for (; data + 32 <= end; data += 32)
+		{
+			acc1 = _Round(acc1, _Read64(data));
+			acc2 = _Round(acc2, _Read64(data + 8));
+			acc3 = _Round(acc3, _Read64(data + 16));
+			acc4 = _Round(acc4, _Read64(data + 24));
+		}
+		hash = _Rotate(acc1, 1) + _Rotate(acc2, 7) + _Rotate(acc3, 12) + _Rotate(acc4, 18);
+		hash = _Merge(hash, acc1);
+		hash = _Merge(hash, acc2);
+		hash = _Merge(hash, acc3);
+		hash = _Merge(hash, acc4);
+	}
+	else
+		hash = seed + _hash_prime3;
+
+	hash += (unsigned long long)size;
+
+	for (; data + 8 <= end; data += 8)
+		hash = _Rotate(hash ^ _Round(0, _Read64(data)), 27) * _hash_prime1 + _hash_prime4;
+	for (; data < end; ++data)
+		hash = _Rotate(hash ^ (*data * _hash_prime3), 11) * _hash_prime1;
+
+	// Final avalanche
+	hash ^= hash >> 33;
+	hash *= _hash_prime2;
+	hash ^= hash >> 29;
+	hash *= _hash_prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
+
+
+//*****************************************************************************
+
+static const char _file_magic[4] = { 'I', 'T', 'R', 'C' };
+
+// Seed of check hash, unrelated to any key seed
+static const unsigned long long _check_seed = 0x27D4EB2F165667C5ULL;
+
+TraceCache::TraceCache(const size_t capacity, const wchar_t* directory)
+	: _capacity(capacity)
+	, _size(0)
+{
+	if (directory && *directory)
+	{
+		_directory = directory;
+		const wchar_t last = _directory.back();
+		if ((last != L'\\') && (last != L'/'))
+			_directory += L'\\';
+	}
+}
+
+/*static*/ unsigned long long TraceCache::Key(const byte* pixels, const int width, const int height, const Options& options)
+{
+	// Versions, size and every option go into the seed, so changing any of them changes the key
+	const int rightangleenhance = options.rightangleenhance ? 1 : 0;
+	byte params[28];
+	memcpy(params + 0, &TraceResultVersion, 4);
+	memcpy(params + 4, &ResultFormatVersion, 4);
+	memcpy(params + 8, &width, 4);
+	memcpy(params + 12, &height, 4);
+	memcpy(params + 16, &options.ltres, 4);
+	memcpy(params + 20, &options.qtres, 4);
+	memcpy(params + 24, &options.pathomit, 4);
+	const unsigned long long seed = _HashBytes(params, sizeof(params), (unsigned long long)rightangleenhance);
+
+	return _HashBytes(pixels, (size_t)width * (size_t)height, seed);
+}
+
+/*static*/ unsigned long long TraceCache::_Check(const byte* pixels, const int width, const int height)
+{
+	return _HashBytes(pixels, (size_t)width * (size_t)height, _check_seed);
+}
+
+std::shared_ptr<const FlatResult> TraceCache::Trace(byte* pixels, const int width, const int height, const Options& options)
+{
+	if (!pixels || (width <= 0) || (height <= 0))
+		return nullptr;
+
+	const unsigned long long key = Key(pixels, width, height, options);
+	const unsigned long long check = _Check(pixels, width, height);
+
+	Entry* entry = _Find(key, check, width, height, options);
+	if (entry)
+	{
+		++Stats.Hits;
+		return entry->result;
+	}
+
+	if (!_directory.empty())
+	{
+		std::shared_ptr<const FlatResult> result = _Load(key, check, width, height, options);
+		if (result)
+		{
+			++Stats.DiskHits;
+			_Add(key, check, width, height, options, result);
+			return result;
+		}
+	}
+
+	++Stats.Misses;
+	const ImageTracer* tracer = _context.Trace(pixels, width, height, options);
+	if (!tracer)
+		return nullptr;
+
+	std::shared_ptr<const FlatResult> result = std::make_shared<FlatResult>(tracer->Layers);
+	if (!_directory.empty())
+		_Store(key, check, width, height, options, *result);
+	_Add(key, check, width, height, options, result);
+	return result;
+}
+
+void TraceCache::Clear()
+{
+	_entries.clear();
+	_index.clear();
+	_size = 0;
+}
+
+TraceCache::Entry* TraceCache::_Find(const unsigned long long key, const unsigned long long check, const int width, const int height, const Options& options)
+{
+	auto it = _index.find(key);
+	if (it == _index.end())
+		return nullptr;
+
+	const Entry& entry = *it->second;
+	if ((entry.check != check) || (entry.width != width) || (entry.height != height) ||
+		(entry.options.ltres != options.ltres) || (entry.options.qtres != options.qtres) ||
+		(entry.options.pathomit != options.pathomit) || (entry.options.rightangleenhance != options.rightangleenhance)
+	)
+		return nullptr;
+
+	// Most recently used
+	_entries.splice(_entries.begin(), _entries, it->second);
+	return &_entries.front();
+}
+
+void TraceCache::_Add(const unsigned long long key, const unsigned long long check, const int width, const int height, const Options& options, const std::shared_ptr<const FlatResult>& result)
+{
+	// Replaces entry having same key but different pixels, size or options
+	auto it = _index.find(key);
+	if (it != _index.end())
+	{
+		_size -= it->second->size;
+		_entries.erase(it->second);
+		_index.erase(it);
+	}
+
+	const size_t size = ResultFile::Size(*result);
+	if (size > _capacity)
+		return;
+
+	while (_size + size > _capacity)
+	{
+		const Entry& last = _entries.back();
+		_size -= last.size;
+		_index.erase(last.key);
+		_entries.pop_back();
+		++Stats.Evictions;
+	}
+
+	Entry entry;
+	entry.key     = key;
+	entry.check   = check;
+	entry.width   = width;
+	entry.height  = height;
+	entry.options = options;
+	entry.result  = result;
+	entry.size    = size;
+	_entries.push_front(entry);
+	_index[key] = _entries.begin();
+	_size += size;
+}
+
+std::shared_ptr<const FlatResult> TraceCache::_Load(const unsigned long long key, const unsigned long long check, const int width, const int height, const Options& options) const
+{
+	FILE* f = _wfopen(_FileName(key).c_str(), L"rb");
+	if (!f)
+		return nullptr;
+
+	FileHeader fileheader;
+	ResultHeader header;
+	bool valid = (fread(&fileheader, sizeof(fileheader), 1, f) == 1) &&
+		(memcmp(fileheader.magic, _file_magic, sizeof(fileheader.magic)) == 0) &&
+		(fileheader.version == TraceResultVersion) &&
+		(fileheader.key == key) && (fileheader.check == check) &&
+		(fileheader.width == width) && (fileheader.height == height) &&
+		(fileheader.ltres == options.ltres) && (fileheader.qtres == options.qtres) &&
+		(fileheader.pathomit == options.pathomit) &&
+		(fileheader.rightangleenhance == (options.rightangleenhance ? 1 : 0)) &&
+		(fread(&header, sizeof(header), 1, f) == 1) &&
+		(header.size >= sizeof(header)) && (header.size <= (unsigned long long)INT_MAX);
+
+	// Read into 8-byte aligned storage, so result can be viewed in place and checked
+	std::vector<unsigned long long> data;
+	if (valid)
+	{
+		const size_t size = (size_t)header.size;
+		data.resize((size + 7) / 8);
+		memcpy(data.data(), &header, sizeof(header));
+		valid = (fread((byte*)data.data() + sizeof(header), 1, size - sizeof(header), f) == size - sizeof(header));
+	}
+	fclose(f);
+	if (!valid)
+		return nullptr;
+
+	std::unique_ptr<ResultView> view(ResultView::FromMemory(data.data(), (size_t)header.size));
+	if (!view)
+		return nullptr;
+	return std::shared_ptr<const FlatResult>(view->ToResult());
+}
+
+void TraceCache::_Store(const unsigned long long key, const unsigned long long check, const int width, const int height, const Options& options, const FlatResult& result) const
+{
+	FileHeader fileheader;
+	memset(&fileheader, 0, sizeof(fileheader));
+	memcpy(fileheader.magic, _file_magic, sizeof(fileheader.magic));
+	fileheader.version           = TraceResultVersion;
+	fileheader.key               = key;
+	fileheader.check             = check;
+	fileheader.width             = width;
+	fileheader.height            = height;
+	fileheader.ltres             = options.ltres;
+	fileheader.qtres             = options.qtres;
+	fileheader.pathomit          = options.pathomit;
+	fileheader.rightangleenhance = options.rightangleenhance ? 1 : 0;
+
+	std::vector<byte> data(sizeof(fileheader) + ResultFile::Size(result));
+	memcpy(data.data(), &fileheader, sizeof(fileheader));
+	ResultFile::Write(result, data.data() + sizeof(fileheader));
+
+	// Cache still works w/o file
+	ResultFile::SaveData(data.data(), data.size(), _FileName(key).c_str());
+}
+
+std::wstring TraceCache::_FileName(const unsigned long long key) const
+{
+	wchar_t name[32];
+	swprintf(name, sizeof(name) / sizeof(name[0]), L"%016llx.itr", key);
+	return _directory + name;
+}
+
+
+};
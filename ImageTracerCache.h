@@ -0,0 +1,123 @@
+// ImageTracerCache.h
+
+#pragma once
+
+
+#include <list>
+#include <string>
+
+#include "ImageTracer.h"
+
+
+namespace ImageTracer
+{
+
+	class CacheStats
+	{
+	public:
+		// Results found in memory
+		long long Hits;
+
+		// Results found on disk, after missing them in memory
+		long long DiskHits;
+
+		// Results actually traced
+		long long Misses;
+
+		// Results dropped from memory to stay within capacity
+		long long Evictions;
+
+		CacheStats();
+	};
+
+
+	// Content-addressed cache in front of tracing: Results are keyed on a hash of the pixels,
+	// image size and all options, so tracing same image with same options again only costs
+	// hashing it. Recently used results are kept in memory up to a given size, and optionally
+	// stored to a directory in binary result format (see ResultFile) to be found again by
+	// other caches or runs. Entries and files also hold image size, options and a second hash
+	// of the pixels independent of the key, and are only used if all of them match, so pixels
+	// whose keys collide don't get each other's results. Not thread safe, use one cache per thread.
+	class TraceCache
+	{
+	public:
+		// Statistics since cache was created
+		CacheStats Stats;
+
+		// Keeps up to capacity bytes of results in memory, measured by their binary size.
+		// If directory is given, results are also stored to and looked up in it.
+		TraceCache(const size_t capacity, const wchar_t* directory = nullptr);
+
+		// Traces color-indexed image data unless it was traced with same options before,
+		// returns nullptr if tracing failed. Results stay valid as long as they're held,
+		// even when dropped from cache.
+		std::shared_ptr<const FlatResult> Trace(byte* pixels, const int width, const int height, const Options& options);
+
+		// Drops all results kept in memory, files stored are kept
+		void Clear();
+
+		// Key of image data traced with options given. Files stored are named after it, so it
+		// stays the same across runs, but changes with TraceResultVersion and ResultFormatVersion.
+		static unsigned long long Key(const byte* pixels, const int width, const int height, const Options& options);
+
+	private:
+		class Entry
+		{
+		public:
+			unsigned long long                key;
+			unsigned long long                check;
+			int                               width;
+			int                               height;
+			Options                           options;
+			std::shared_ptr<const FlatResult> result;
+			size_t                            size;
+		};
+
+		// Start of files stored, followed by result in binary format
+		class FileHeader
+		{
+		public:
+			char               magic[4];     // "ITRC"
+			unsigned int       version;      // TraceResultVersion
+			unsigned long long key;
+			unsigned long long check;
+			int                width;
+			int                height;
+			float              ltres;
+			float              qtres;
+			int                pathomit;
+			int                rightangleenhance;
+		};
+
+		size_t       _capacity;
+		size_t       _size;
+		std::wstring _directory;
+
+		// Most recently used first, indexed by key
+		std::list<Entry> _entries;
+		std::unordered_map<unsigned long long, std::list<Entry>::iterator> _index;
+
+		// Tracer for misses, keeping its buffers from one to the next
+		TracerContext _context;
+
+		// Second hash of image data, seeded apart from key so both only match for same pixels
+		static unsigned long long _Check(const byte* pixels, const int width, const int height);
+
+		// Entry for key given if it was traced from pixels with same check, size and options,
+		// nullptr otherwise
+		Entry* _Find(const unsigned long long key, const unsigned long long check, const int width, const int height, const Options& options);
+
+		// Adds result as most recently used, dropping least recently used ones to stay within capacity
+		void _Add(const unsigned long long key, const unsigned long long check, const int width, const int height, const Options& options, const std::shared_ptr<const FlatResult>& result);
+
+		// Result stored to file for key given if it was traced from pixels with same check,
+		// size and options by same version, nullptr otherwise
+		std::shared_ptr<const FlatResult> _Load(const unsigned long long key, const unsigned long long check, const int width, const int height, const Options& options) const;
+
+		// Stores result to file for key given, along with check, size and options
+		void _Store(const unsigned long long key, const unsigned long long check, const int width, const int height, const Options& options, const FlatResult& result) const;
+
+		std::wstring _FileName(const unsigned long long key) const;
+	};
+
+};
@@ -46,7 +46,7 @@ Segment::Segment(ImageTracer::Segment& seg)
 
 Segments::Segments(ImageTracer::SegmentList& list)
 {
-	for (auto s : list)
+	for (auto& s : list)
 		Add(gcnew Segment(s));
 }
 
@@ -58,9 +58,23 @@ ReadOnlyCollection<Segment^>^ Poly::Segments::get()
 	return _segments->AsReadOnly(); 
 } 
 
+bool Poly::IsHole::get() 
+{ 
+	return _is_hole; 
+} 
+
+ReadOnlyCollection<int>^ Poly::HoleChildren::get() 
+{ 
+	return _hole_children->AsReadOnly(); 
+} 
+
 Poly::Poly(ImageTracer::Poly& poly)
 {
 	_segments = gcnew ::ImageTracerDotNet::Segments(poly.Segments);
+	_is_hole = poly.IsHole;
+	_hole_children = gcnew List<int>();
+	for (auto c : poly.HoleChildren)
+		_hole_children->Add(c);
 }
 
 
@@ -68,7 +82,7 @@ Poly::Poly(ImageTracer::Poly& poly)
 
 Polys::Polys(ImageTracer::PolyList& list)
 {
-	for (auto p : list)
+	for (auto& p : list)
 		Add(gcnew Poly(p));
 }
 
@@ -150,7 +164,7 @@ void ImageTracerDotNet::_Trace(array<byte>^ pixels, int width, int height, Optio
 		trc = ImageTracer::ImageTracer::Trace(p, width, height, opt);
 		if (trc)
 		{
-			for (auto l : trc->Layers)
+			for (auto& l : trc->Layers)
 				_layers->Add(gcnew Layer(l));
 		}
 	}
@@ -48,10 +48,22 @@ namespace ImageTracerDotNet
 			ReadOnlyCollection<Segment^>^ get(); 
 		}
 
+		// Hole polygons are cut out of their parent
+		property bool IsHole { 
+			bool get(); 
+		}
+
+		// Indices of hole polygons within same layer having this one as parent
+		property ReadOnlyCollection<int>^ HoleChildren { 
+			ReadOnlyCollection<int>^ get(); 
+		}
+
 		Poly(ImageTracer::Poly& poly);
 
 	private:
 		::ImageTracerDotNet::Segments^ _segments;
+		bool                           _is_hole;
+		List<int>^                     _hole_children;
 	};
 
 
@@ -117,7 +129,7 @@ namespace ImageTracerDotNet
 		// Layering method
 		//
 		//layering : 0,
-		//=> Only sequencial layering for now
+		//=> Single pass over all color indices, yields same edge nodes as sequencial layering
 
 
 		// SVG rendering
@@ -0,0 +1,366 @@
+// ImageTracerFile.cpp
+//
+
+#include "stdafx.h"
+#include <limits.h>
+#include <new>
+#include <string>
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+#include "ImageTracerFile.h"
+
+
+namespace ImageTracer
+{
+
+// Binary result format and memory mapped views of it
+
+
+static const char _result_magic[4] = { 'I', 'T', 'R', 'S' };
+
+static size_t _Align(const size_t offset)
+{
+	return (offset + 7) & ~(size_t)7;
+}
+
+// Element count and size of each section of result given
+static void _Sections(const FlatResult& flat, size_t* counts, size_t* sizes)
+{
+	counts[ResultHeader::Section_LayerColors]  = flat.LayerColors.size();
+	counts[ResultHeader::Section_LayerOffsets] = flat.LayerOffsets.size();
+	counts[ResultHeader::Section_PolyOffsets]  = flat.PolyOffsets.size();
+	counts[ResultHeader::Section_PolyHoles]    = flat.PolyHoles.size();
+	counts[ResultHeader::Section_PolyBBoxes]   = flat.PolyBBoxes.size();
+	counts[ResultHeader::Section_HoleOffsets]  = flat.HoleOffsets.size();
+	counts[ResultHeader::Section_HoleChildren] = flat.HoleChildren.size();
+	counts[ResultHeader::Section_Segments]     = flat.Segments.size();
+
+	for (int s = 0; s < ResultHeader::Section_Count; ++s)
+		sizes[s] = sizeof(int);
+	sizes[ResultHeader::Section_Segments] = sizeof(Segment);
+}
+
+
+//*****************************************************************************
+
+/*static*/ size_t ResultFile::Size(const FlatResult& flat)
+{
+	size_t counts[ResultHeader::Section_Count], sizes[ResultHeader::Section_Count];
+	_Sections(flat, counts, sizes);
+
+	size_t size = _Align(sizeof(ResultHeader));
+	for (int s = 0; s < ResultHeader::Section_Count; ++s)
+		size = _Align(size + counts[s] * sizes[s]);
+	return size;
+}
+
+/*static*/ void ResultFile::Write(const FlatResult& flat, byte* data)
+{
+	size_t counts[ResultHeader::Section_Count], sizes[ResultHeader::Section_Count];
+	_Sections(flat, counts, sizes);
+
+	const void* arrays[ResultHeader::Section_Count] = {
+		flat.LayerColors.data(),
+		flat.LayerOffsets.data(),
+		flat.PolyOffsets.data(),
+		flat.PolyHoles.data(),
+		flat.PolyBBoxes.data(),
+		flat.HoleOffsets.data(),
+		flat.HoleChildren.data(),
+		flat.Segments.data(),
+	};
+
+	// Padding is zeroed, so same results always yield same bytes
+	const size_t size = Size(flat);
+	memset(data, 0, size);
+
+	ResultHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, _result_magic, sizeof(header.magic));
+	header.version      = ResultFormatVersion;
+	header.layercount   = (unsigned int)flat.LayerColors.size();
+	header.polycount    = (unsigned int)flat.PolyHoles.size();
+	header.childcount   = (unsigned int)flat.HoleChildren.size();
+	header.segmentcount = (unsigned int)flat.Segments.size();
+	header.size         = size;
+
+	size_t offset = _Align(sizeof(ResultHeader));
+	for (int s = 0; s < ResultHeader::Section_Count; ++s)
+	{
+		header.sections[s] = offset;
+		if (counts[s])
+			memcpy(data + offset, arrays[s], counts[s] * sizes[s]);
+		offset = _Align(offset + counts[s] * sizes[s]);
+	}
+
+	memcpy(data, &header, sizeof(header));
+}
+
+/*static*/ bool ResultFile::Save(const FlatResult& flat, const wchar_t* filename)
+{
+	std::vector<byte> data(Size(flat));
+	Write(flat, data.data());
+	return SaveData(data.data(), data.size(), filename);
+}
+
+/*static*/ bool ResultFile::SaveData(const byte* data, const size_t size, const wchar_t* filename)
+{
+	// Written to a temporary file first and renamed when complete, so readers never see
+	// partial files. Name is unique per thread, so concurrent writers don't collide.
+	wchar_t suffix[64];
+	swprintf(suffix, sizeof(suffix) / sizeof(suffix[0]), L".%lu.%lu.tmp", (unsigned long)GetCurrentProcessId(), (unsigned long)GetCurrentThreadId());
+	const std::wstring tempname = std::wstring(filename) + suffix;
+
+	FILE* f = _wfopen(tempname.c_str(), L"wb");
+	if (!f)
+		return false;
+	const bool written = (fwrite(data, 1, size, f) == size);
+	if ((fclose(f) != 0) || !written || !MoveFileExW(tempname.c_str(), filename, MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileW(tempname.c_str());
+		return false;
+	}
+	return true;
+}
+
+
+//*****************************************************************************
+
+ResultView::ResultView()
+	: _data(nullptr)
+	, _header(nullptr)
+	, _file(nullptr)
+	, _mapping(nullptr)
+{ }
+
+ResultView::~ResultView()
+{
+	if (_mapping)
+	{
+		if (_data)
+			UnmapViewOfFile(_data);
+		CloseHandle((HANDLE)_mapping);
+	}
+	if (_file)
+		CloseHandle((HANDLE)_file);
+}
+
+/*static*/ ResultView* ResultView::Open(const wchar_t* filename)
+{
+	// View is allocated first and takes each handle as soon as it's opened,
+	// so deleting it releases whatever was opened before failing
+	ResultView* view = new (std::nothrow) ResultView();
+	if (!view)
+		return nullptr;
+
+	HANDLE file = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		delete view;
+		return nullptr;
+	}
+	view->_file = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || (size.QuadPart < (LONGLONG)sizeof(ResultHeader)))
+	{
+		delete view;
+		return nullptr;
+	}
+
+	view->_mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!view->_mapping)
+	{
+		delete view;
+		return nullptr;
+	}
+
+	view->_data = (const byte*)MapViewOfFile((HANDLE)view->_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view->_data || !_Validate(view->_data, (size_t)size.QuadPart))
+	{
+		delete view;
+		return nullptr;
+	}
+	view->_header = (const ResultHeader*)view->_data;
+	return view;
+}
+
+/*static*/ ResultView* ResultView::FromMemory(const void* data, const size_t size)
+{
+	if (!data || !_Validate((const byte*)data, size))
+		return nullptr;
+
+	ResultView* view = new (std::nothrow) ResultView();
+	if (!view)
+		return nullptr;
+	view->_data   = (const byte*)data;
+	view->_header = (const ResultHeader*)data;
+	return view;
+}
+
+/*static*/ bool ResultView::_Validate(const byte* data, const size_t size)
+{
+	// Arrays are read in place, so they need to be aligned
+	if ((size < sizeof(ResultHeader)) || (((size_t)data & 7) != 0))
+		return false;
+
+	const ResultHeader* header = (const ResultHeader*)data;
+	if ((memcmp(header->magic, _result_magic, sizeof(header->magic)) != 0) ||
+		(header->version != ResultFormatVersion) ||
+		(header->size > size)
+	)
+		return false;
+
+	size_t counts[ResultHeader::Section_Count];
+	counts[ResultHeader::Section_LayerColors]  = header->layercount;
+	counts[ResultHeader::Section_LayerOffsets] = (size_t)header->layercount + 1;
+	counts[ResultHeader::Section_PolyOffsets]  = (size_t)header->polycount + 1;
+	counts[ResultHeader::Section_PolyHoles]    = header->polycount;
+	counts[ResultHeader::Section_PolyBBoxes]   = (size_t)header->polycount * 4;
+	counts[ResultHeader::Section_HoleOffsets]  = (size_t)header->polycount + 1;
+	counts[ResultHeader::Section_HoleChildren] = header->childcount;
+	counts[ResultHeader::Section_Segments]     = header->segmentcount;
+
+	for (int s = 0; s < ResultHeader::Section_Count; ++s)
+	{
+		const unsigned long long offset = header->sections[s];
+		const unsigned long long bytes = counts[s] * ((s == ResultHeader::Section_Segments) ? sizeof(Segment) : sizeof(int));
+		if ((offset < sizeof(ResultHeader)) || ((offset & 7) != 0) || (offset > header->size) || (bytes > header->size - offset))
+			return false;
+	}
+
+	// Offsets and indices are stored as int
+	if ((header->layercount > INT_MAX) || (header->polycount > INT_MAX) || (header->childcount > INT_MAX) || (header->segmentcount > INT_MAX))
+		return false;
+
+	// Offset tables need to be monotonic and span all items of next level
+	const int* layeroffsets = (const int*)(data + header->sections[ResultHeader::Section_LayerOffsets]);
+	const int* polyoffsets  = (const int*)(data + header->sections[ResultHeader::Section_PolyOffsets]);
+	const int* holeoffsets  = (const int*)(data + header->sections[ResultHeader::Section_HoleOffsets]);
+	if (!_ValidOffsets(layeroffsets, header->layercount, header->polycount) ||
+		!_ValidOffsets(polyoffsets, header->polycount, header->segmentcount) ||
+		!_ValidOffsets(holeoffsets, header->polycount, header->childcount)
+	)
+		return false;
+
+	// Hole children are poly indices within their layer
+	const int* children = (const int*)(data + header->sections[ResultHeader::Section_HoleChildren]);
+	for (unsigned int l = 0; l < header->layercount; ++l)
+	{
+		const int layerpolys = layeroffsets[l + 1] - layeroffsets[l];
+		for (int c = holeoffsets[layeroffsets[l]]; c < holeoffsets[layeroffsets[l + 1]]; ++c)
+		{
+			if ((children[c] < 0) || (children[c] >= layerpolys))
+				return false;
+		}
+	}
+	return true;
+}
+
+/*static*/ bool ResultView::_ValidOffsets(const int* offsets, const unsigned int count, const unsigned int total)
+{
+	if (offsets[0] != 0)
+		return false;
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		if (offsets[i] > offsets[i + 1])
+			return false;
+	}
+	return (offsets[count] == (int)total);
+}
+
+const int* ResultView::_Ints(const ResultHeader::Section section) const
+{
+	return (const int*)(_data + _header->sections[section]);
+}
+
+int ResultView::LayerCount() const
+{
+	return (int)_header->layercount;
+}
+
+const int* ResultView::LayerColors() const
+{
+	return _Ints(ResultHeader::Section_LayerColors);
+}
+
+const int* ResultView::LayerOffsets() const
+{
+	return _Ints(ResultHeader::Section_LayerOffsets);
+}
+
+int ResultView::PolyCount() const
+{
+	return (int)_header->polycount;
+}
+
+const int* ResultView::PolyOffsets() const
+{
+	return _Ints(ResultHeader::Section_PolyOffsets);
+}
+
+const int* ResultView::PolyHoles() const
+{
+	return _Ints(ResultHeader::Section_PolyHoles);
+}
+
+const int* ResultView::PolyBBoxes() const
+{
+	return _Ints(ResultHeader::Section_PolyBBoxes);
+}
+
+const int* ResultView::HoleOffsets() const
+{
+	return _Ints(ResultHeader::Section_HoleOffsets);
+}
+
+int ResultView::HoleChildCount() const
+{
+	return (int)_header->childcount;
+}
+
+const int* ResultView::HoleChildren() const
+{
+	return _Ints(ResultHeader::Section_HoleChildren);
+}
+
+int ResultView::SegmentCount() const
+{
+	return (int)_header->segmentcount;
+}
+
+const Segment* ResultView::Segments() const
+{
+	return (const Segment*)(_data + _header->sections[ResultHeader::Section_Segments]);
+}
+
+FlatResult* ResultView::ToResult() const
+{
+	FlatResult* flat = new (std::nothrow) FlatResult();
+	if (!flat)
+		return nullptr;
+
+	try
+	{
+		flat->LayerColors.assign(LayerColors(), LayerColors() + LayerCount());
+		flat->LayerOffsets.assign(LayerOffsets(), LayerOffsets() + LayerCount() + 1);
+		flat->PolyOffsets.assign(PolyOffsets(), PolyOffsets() + PolyCount() + 1);
+		flat->PolyHoles.assign(PolyHoles(), PolyHoles() + PolyCount());
+		flat->PolyBBoxes.assign(PolyBBoxes(), PolyBBoxes() + PolyCount() * 4);
+		flat->HoleOffsets.assign(HoleOffsets(), HoleOffsets() + PolyCount() + 1);
+		flat->HoleChildren.assign(HoleChildren(), HoleChildren() + HoleChildCount());
+		flat->Segments.assign(Segments(), Segments() + SegmentCount());
+	}
+	catch (...)
+	{
+		delete flat;
+		return nullptr;
+	}
+	return flat;
+}
+
+
+};
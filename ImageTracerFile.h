@@ -0,0 +1,119 @@
+// ImageTracerFile.h
+
+#pragma once
+
+
+#include "ImageTracer.h"
+
+
+namespace ImageTracer
+{
+
+	// Binary result format: Header followed by the arrays of a FlatResult, each one starting
+	// at an 8-byte aligned offset given in header. All values are stored in native (little
+	// endian) byte order, segments are stored as they are in memory (type as int, 6 floats).
+	// Readers need to reject any version they don't know.
+	const unsigned int ResultFormatVersion = 1;
+
+	class ResultHeader
+	{
+	public:
+		enum Section
+		{
+			Section_LayerColors,
+			Section_LayerOffsets,
+			Section_PolyOffsets,
+			Section_PolyHoles,
+			Section_PolyBBoxes,
+			Section_HoleOffsets,
+			Section_HoleChildren,
+			Section_Segments,
+			Section_Count
+		};
+
+		char               magic[4];         // "ITRS"
+		unsigned int       version;          // ResultFormatVersion
+		unsigned int       layercount;
+		unsigned int       polycount;
+		unsigned int       childcount;
+		unsigned int       segmentcount;
+		unsigned long long size;             // Total size in bytes, header included
+		unsigned long long sections[Section_Count];  // Byte offset of each array
+	};
+
+
+	class ResultFile
+	{
+	public:
+		// Size of result given in binary format
+		static size_t Size(const FlatResult& flat);
+
+		// Stores result given in binary format, data needs to hold Size() bytes
+		static void Write(const FlatResult& flat, byte* data);
+
+		// Stores result given in binary format to file, replacing it as a whole once written
+		// completely. Returns false if writing failed, file is left untouched then.
+		static bool Save(const FlatResult& flat, const wchar_t* filename);
+
+		// Stores data given to file same way as Save(), for results embedded in other data
+		static bool SaveData(const byte* data, const size_t size, const wchar_t* filename);
+	};
+
+
+	// Read-only view of a result in binary format, arrays are read in place w/o copying
+	// or parsing them. Header, array bounds, offset tables and hole child indices are
+	// checked when opening, so indexing by them stays within arrays. Other values (colors,
+	// hole flags, bounding boxes, segments) are handed out as stored.
+	class ResultView
+	{
+	public:
+		// Maps file given into memory, returns nullptr if it can't be opened or isn't valid
+		static ResultView* Open(const wchar_t* filename);
+
+		// Views data given, which needs to stay valid as long as the view.
+		// Returns nullptr if data isn't valid.
+		static ResultView* FromMemory(const void* data, const size_t size);
+
+		~ResultView();
+
+		// Same layout as FlatResult
+		int            LayerCount() const;
+		const int*     LayerColors() const;
+		const int*     LayerOffsets() const;
+
+		int            PolyCount() const;
+		const int*     PolyOffsets() const;
+		const int*     PolyHoles() const;
+		const int*     PolyBBoxes() const;
+		const int*     HoleOffsets() const;
+
+		int            HoleChildCount() const;
+		const int*     HoleChildren() const;
+
+		int            SegmentCount() const;
+		const Segment* Segments() const;
+
+		// Copies all arrays viewed into a new result, nullptr if it can't be allocated
+		FlatResult* ToResult() const;
+
+	private:
+		const byte*         _data;
+		const ResultHeader* _header;
+
+		// Handles of file mapped, if any
+		void*               _file;
+		void*               _mapping;
+
+		ResultView();
+		ResultView(const ResultView&) = delete;
+		ResultView& operator=(const ResultView&) = delete;
+
+		const int* _Ints(const ResultHeader::Section section) const;
+
+		static bool _Validate(const byte* data, const size_t size);
+
+		// Offset table of count items starts at 0, never decreases and ends at total
+		static bool _ValidOffsets(const int* offsets, const unsigned int count, const unsigned int total);
+	};
+
+};
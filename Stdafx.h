@@ -7,20 +7,28 @@
 #define _CRT_SECURE_NO_WARNINGS
 
 
+#ifdef _MANAGED
 #include <vcclr.h>
+#endif
 
 #include <stdio.h>
 #include <string.h>
 #include <memory.h>
+#include <intrin.h>
+
+#include <algorithm>
 
 #include <omp.h>
 
 
+// Files compiled as native code (see project) include this without precompiling it
+#ifdef _MANAGED
 using namespace System;
 using namespace System::Collections::Generic;
 using namespace System::Collections::ObjectModel;
 using namespace System::Diagnostics;
 using namespace System::IO;
+#endif
 
 
 #ifndef byte
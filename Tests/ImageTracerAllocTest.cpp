@@ -0,0 +1,231 @@
+// ImageTracerAllocTest.cpp
+//
+// Counts heap allocations by replacing global operator new, checks that tracing same image
+// again with a warm TracerContext doesn't allocate, with layers as well as paths traced in 
+// parallel, and that cold tracing doesn't allocate per segment. Returns number of checks failed.
+
+#include "../Stdafx.h"
+
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+#include "TestCommon.h"
+
+
+static std::atomic<long long> _allocations(0);
+
+void* operator new(size_t size)
+{
+	++_allocations;
+	void* p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	++_allocations;
+	return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+
+//*****************************************************************************
+
+// Colors of image are reduced to number given, or extended to it by specks of further colors
+static void _TestSameImage(const int width, const int height, const unsigned int seed, const int colors = 6)
+{
+	std::vector<byte> pixels;
+	_FillImage(pixels, width, height, seed);
+	if (colors < 6)
+	{
+		for (auto& p : pixels)
+			p = (byte)(p % colors);
+	}
+	for (int k = 0; (colors > 6) && (k < width * height); k += 97)
+		pixels[k] = (byte)(6 + k % (colors - 6));
+
+	ImageTracer::Options options;
+	ImageTracer::TracerContext context;
+	CHECK(context.Trace(pixels.data(), width, height, options) != nullptr);
+
+	const long long before = _allocations;
+	const ImageTracer::ImageTracer* tracer = context.Trace(pixels.data(), width, height, options);
+	const long long allocations = _allocations - before;
+
+	printf("%dx%d, seed %u, %d color(s): %lld allocation(s) on second trace%s\n", width, height, seed, colors, allocations,
+		(tracer && tracer->Stats.ParallelPaths) ? ", paths traced in parallel" : "");
+	CHECK(tracer != nullptr);
+#ifndef _DEBUG
+	// Debug builds allocate for each container constructed to track its iterators
+	CHECK(allocations == 0);
+#endif
+	if (!tracer)
+		return;
+
+	// Storage taken over doesn't change results
+	ImageTracer::ImageTracer* fresh = ImageTracer::ImageTracer::Trace(pixels.data(), width, height, options);
+	CHECK(fresh != nullptr);
+	if (fresh)
+	{
+		CHECK(_SameResults(tracer->Layers, fresh->Layers));
+		delete fresh;
+	}
+}
+
+// Same image traced again with default number of threads, and with 8 threads having layers
+// traced in parallel as well as paths of images with fewer colors, with many paths as well
+// as with few ones
+static void _TestSameImages()
+{
+	_TestSameImage(800, 600, 3);
+	_TestSameImage(640, 480, 17);
+	_TestSameImage(97, 1031, 5);
+	_TestSameImage(800, 600, 3, 2);
+
+#ifdef _OPENMP
+	const int threads = omp_get_max_threads();
+	omp_set_num_threads(8);
+	_TestSameImage(800, 600, 3, 12);
+	_TestSameImage(800, 600, 3);
+	_TestSameImage(800, 600, 3, 3);
+	_TestSameImage(300, 200, 9, 2);
+	omp_set_num_threads(threads);
+#endif
+}
+
+static void _TestCounting()
+{
+	// Make sure replaced operator new is actually used
+	const long long before = _allocations;
+	std::vector<int>* v = new std::vector<int>(16);
+	CHECK(_allocations - before >= 2);
+	delete v;
+}
+
+// Traces image cold, returns number of allocations along with counts of polygons, hole
+// parents, layers and segments
+static long long _TraceCold(std::vector<byte>& pixels, const int width, const int height, size_t& polys, size_t& parents, size_t& layers, size_t& segments)
+{
+	polys = parents = layers = segments = 0;
+
+	const long long before = _allocations;
+	ImageTracer::ImageTracer* tracer = ImageTracer::ImageTracer::Trace(pixels.data(), width, height, ImageTracer::Options());
+	const long long allocations = _allocations - before;
+
+	CHECK(tracer != nullptr);
+	if (!tracer)
+		return allocations;
+
+	layers = tracer->Layers.size();
+	for (auto& layer : tracer->Layers)
+	{
+		polys += layer.Polygons.size();
+		for (auto& poly : layer.Polygons)
+		{
+			segments += poly.Segments.size();
+			if (!poly.HoleChildren.empty())
+				++parents;
+		}
+	}
+	delete tracer;
+	return allocations;
+}
+
+// Results allocate once per list they hold, scratch memory grows with image size, but
+// neither of them with number of segments. Scratch memory is kept per thread, so a single 
+// one is used to not have it grow with number of threads.
+static void _TestNoSegmentCopies()
+{
+#ifdef _OPENMP
+	const int threads = omp_get_max_threads();
+	omp_set_num_threads(1);
+#endif
+
+	size_t polys, parents, layers, segments;
+
+	// Scratch lists (edge nodes, grid, segments being fitted) only grow a few times
+	// for images this size
+	const int slack = 200;
+	std::vector<byte> pixels;
+	_FillImage(pixels, 1000, 680, 4, 350);
+	long long allocations = _TraceCold(pixels, 1000, 680, polys, parents, layers, segments);
+	printf("Cold trace: %lld allocation(s) for %zu poly(s), %zu layer(s), %zu segment(s)\n", allocations, polys, layers, segments);
+	CHECK(allocations <= (long long)(polys + parents + layers) + slack);
+
+	// Same polygons once as squares and once as discs, discs having many more segments
+	long long counts[2];
+	size_t segmentcounts[2];
+	for (int shape = 0; shape < 2; ++shape)
+	{
+		pixels.assign(800 * 600, 0);
+		for (int cy = 75; cy < 600; cy += 150)
+		{
+			for (int cx = 66; cx < 800; cx += 133)
+			{
+				for (int y = cy - 50; y < cy + 50; ++y)
+				{
+					for (int x = cx - 50; x < cx + 50; ++x)
+					{
+						if ((shape == 0) || ((x - cx) * (x - cx) + (y - cy) * (y - cy) < 50 * 50))
+							pixels[y * 800 + x] = 1;
+					}
+				}
+			}
+		}
+		counts[shape] = _TraceCold(pixels, 800, 600, polys, parents, layers, segmentcounts[shape]);
+		// Background with a hole for each shape, shapes themselves
+		CHECK(polys == 1 + 2 * 24);
+	}
+	printf("Squares: %lld allocation(s) for %zu segment(s), discs: %lld allocation(s) for %zu segment(s)\n",
+		counts[0], segmentcounts[0], counts[1], segmentcounts[1]);
+	CHECK(segmentcounts[1] >= 4 * segmentcounts[0]);
+	CHECK(std::abs(counts[1] - counts[0]) <= 8);
+
+#ifdef _OPENMP
+	omp_set_num_threads(threads);
+#endif
+}
+
+
+//*****************************************************************************
+
+int main()
+{
+	_TestCounting();
+	_TestSameImages();
+	_TestNoSegmentCopies();
+
+	return _Summary();
+}
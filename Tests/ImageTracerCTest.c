@@ -0,0 +1,184 @@
+// ImageTracerCTest.c
+//
+// Calls C interface of native ImageTracerC.dll from plain C, returns number of checks failed.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../ImageTracerC.h"
+
+
+static int _failed = 0;
+
+#define CHECK(cond) \
+	do { if (!(cond)) { printf("%s(%d): Check failed: %s\n", __FILE__, __LINE__, #cond); ++_failed; } } while (0)
+
+
+#define WIDTH  16
+#define HEIGHT 12
+
+// Background 0, square of color 1 with color 2 inside, so color 1 has a hole
+static void _FillImage(unsigned char* pixels)
+{
+	int x, y;
+
+	memset(pixels, 0, WIDTH * HEIGHT);
+	for (y = 2; y < 10; ++y)
+		for (x = 3; x < 13; ++x)
+			pixels[y * WIDTH + x] = 1;
+	for (y = 4; y < 8; ++y)
+		for (x = 6; x < 10; ++x)
+			pixels[y * WIDTH + x] = 2;
+}
+
+
+//*****************************************************************************
+
+static void _TestOptions(void)
+{
+	it_options options;
+
+	memset(&options, 0, sizeof(options));
+	it_options_default(&options);
+	CHECK(options.ltres == 1.0f);
+	CHECK(options.qtres == 1.0f);
+	CHECK(options.pathomit == 8);
+	CHECK(options.rightangleenhance == 1);
+
+	it_options_default(NULL);
+}
+
+static void _TestTrace(void)
+{
+	unsigned char pixels[WIDTH * HEIGHT];
+	it_result* result;
+	int layer_count, poly_count, segment_count;
+	const int *colors, *layer_offsets, *poly_offsets, *holes, *bboxes, *hole_offsets, *children;
+	const it_segment* segments;
+	int l, p, c, hole_found = 0;
+
+	_FillImage(pixels);
+	result = it_trace(pixels, WIDTH, HEIGHT, NULL);
+	CHECK(result != NULL);
+	if (!result)
+		return;
+
+	layer_count   = it_result_layer_count(result);
+	poly_count    = it_result_poly_count(result);
+	segment_count = it_result_segment_count(result);
+	colors        = it_result_layer_colors(result);
+	layer_offsets = it_result_layer_offsets(result);
+	poly_offsets  = it_result_poly_offsets(result);
+	holes         = it_result_poly_holes(result);
+	bboxes        = it_result_poly_bboxes(result);
+	hole_offsets  = it_result_hole_offsets(result);
+	children      = it_result_hole_children(result);
+	segments      = it_result_segments(result);
+
+	CHECK(layer_count == 3);
+	CHECK(poly_count > 0);
+	CHECK(segment_count > 0);
+	if ((layer_count != 3) || (poly_count <= 0) || (segment_count <= 0))
+	{
+		it_free(result);
+		return;
+	}
+
+	// Offset tables start at 0, only grow and end at item count of next level
+	CHECK(layer_offsets[0] == 0);
+	CHECK(layer_offsets[layer_count] == poly_count);
+	CHECK(poly_offsets[0] == 0);
+	CHECK(poly_offsets[poly_count] == segment_count);
+	CHECK(hole_offsets[0] == 0);
+
+	for (l = 0; l < layer_count; ++l)
+	{
+		CHECK(colors[l] == l);
+		CHECK(layer_offsets[l] <= layer_offsets[l + 1]);
+
+		for (p = layer_offsets[l]; p < layer_offsets[l + 1]; ++p)
+		{
+			CHECK(poly_offsets[p] < poly_offsets[p + 1]);
+			CHECK(hole_offsets[p] <= hole_offsets[p + 1]);
+			CHECK((holes[p] == 0) || (holes[p] == 1));
+			CHECK(bboxes[p * 4 + 0] <= bboxes[p * 4 + 2]);
+			CHECK(bboxes[p * 4 + 1] <= bboxes[p * 4 + 3]);
+
+			// Hole children are holes of same layer, counted from its first poly
+			for (c = hole_offsets[p]; c < hole_offsets[p + 1]; ++c)
+			{
+				CHECK((children[c] >= 0) && (children[c] < layer_offsets[l + 1] - layer_offsets[l]));
+				CHECK(holes[layer_offsets[l] + children[c]] == 1);
+			}
+
+			if ((l == 1) && holes[p])
+				hole_found = 1;
+		}
+	}
+	CHECK(hole_found);
+
+	for (c = 0; c < segment_count; ++c)
+		CHECK((segments[c].type == IT_SEGMENT_LINE) || (segments[c].type == IT_SEGMENT_QUADSPLINE));
+
+	it_free(result);
+}
+
+static void _TestOptionsUsed(void)
+{
+	unsigned char pixels[WIDTH * HEIGHT];
+	it_options options;
+	it_result* result;
+
+	// Omitting all paths leaves no polys
+	_FillImage(pixels);
+	it_options_default(&options);
+	options.pathomit = WIDTH * HEIGHT * 4;
+	result = it_trace(pixels, WIDTH, HEIGHT, &options);
+	CHECK(result != NULL);
+	CHECK(it_result_poly_count(result) == 0);
+	CHECK(it_result_segment_count(result) == 0);
+	it_free(result);
+}
+
+static void _TestRejected(void)
+{
+	unsigned char pixels[WIDTH * HEIGHT];
+
+	_FillImage(pixels);
+	CHECK(it_trace(NULL, WIDTH, HEIGHT, NULL) == NULL);
+	CHECK(it_trace(pixels, 0, HEIGHT, NULL) == NULL);
+	CHECK(it_trace(pixels, WIDTH, -1, NULL) == NULL);
+
+	// Reserved color index
+	pixels[5] = 255;
+	CHECK(it_trace(pixels, WIDTH, HEIGHT, NULL) == NULL);
+
+	// Nothing to trace
+	memset(pixels, 1, sizeof(pixels));
+	CHECK(it_trace(pixels, WIDTH, HEIGHT, NULL) == NULL);
+
+	// Null handles are fine everywhere
+	it_free(NULL);
+	CHECK(it_result_layer_count(NULL) == 0);
+	CHECK(it_result_poly_count(NULL) == 0);
+	CHECK(it_result_segment_count(NULL) == 0);
+	CHECK(it_result_layer_offsets(NULL) == NULL);
+	CHECK(it_result_segments(NULL) == NULL);
+}
+
+
+//*****************************************************************************
+
+int main(void)
+{
+	_TestOptions();
+	_TestTrace();
+	_TestOptionsUsed();
+	_TestRejected();
+
+	if (_failed)
+		printf("%d check(s) failed\n", _failed);
+	else
+		printf("All checks passed\n");
+	return _failed;
+}
@@ -0,0 +1,884 @@
+// ImageTracerTest.cpp
+//
+// Checks plain tracing against results of the original implementation, tracing variants
+// (kernels, parallel and incremental tracing, streaming, batches) against plain tracing, 
+// as well as storing and caching results. Returns number of checks failed.
+
+#include "../Stdafx.h"
+
+#include "TestCommon.h"
+#include "../ImageTracerCache.h"
+#include "../ImageTracerFile.h"
+#include "TraceGolden.h"
+
+
+//*****************************************************************************
+
+// All kernels supported by CPU store same offsets as scalar one, for every start and
+// tail length not filling a whole vector
+static void _TestScanWindows()
+{
+	const ImageTracer::Kernels::ScanWindowsFunc scalar = ImageTracer::Kernels::ScanWindows(ImageTracer::KernelSet_Scalar);
+
+	unsigned int seed = 11;
+	std::vector<byte> above(200), below(200);
+	std::vector<int> expected(200), offsets(200);
+	int tested = 0;
+
+	for (int set = ImageTracer::KernelSet_SSE2; set < ImageTracer::KernelSet_Count; ++set)
+	{
+		if (!ImageTracer::Kernels::Supported((ImageTracer::KernelSet)set))
+		{
+			printf("Kernel set %d not supported, skipped\n", set);
+			continue;
+		}
+		const ImageTracer::Kernels::ScanWindowsFunc kernel = ImageTracer::Kernels::ScanWindows((ImageTracer::KernelSet)set);
+
+		for (int colors = 1; colors <= 3; ++colors)
+		{
+			for (int start = 0; start <= 33; ++start)
+			{
+				// Tails alone as well as after a few whole vectors
+				for (int length = 0; length <= 33 + 64; ++length)
+				{
+					const int count = start + length;
+					for (int k = 0; k <= count; ++k)
+					{
+						above[k] = (byte)(_Next(seed) % colors);
+						below[k] = (byte)(_Next(seed) % colors);
+					}
+
+					const int n = scalar(above.data(), below.data(), start, count, expected.data());
+					const int m = kernel(above.data(), below.data(), start, count, offsets.data());
+					CHECK(n == m);
+					if (n == m)
+						CHECK(std::equal(expected.begin(), expected.begin() + n, offsets.begin()));
+					++tested;
+				}
+			}
+		}
+	}
+	printf("Scan windows: %d rows compared\n", tested);
+}
+
+
+// Error kernels supported by CPU yield same results as scalar ones, for counts not filling
+// whole vectors and for points tied for largest distance
+static void _TestErrorKernels()
+{
+	const ImageTracer::Kernels::LineErrorsFunc scalarline = ImageTracer::Kernels::LineErrors(ImageTracer::KernelSet_Scalar);
+	const ImageTracer::Kernels::SplineErrorsFunc scalarspline = ImageTracer::Kernels::SplineErrors(ImageTracer::KernelSet_Scalar);
+
+	unsigned int seed = 23;
+	std::vector<int> xs(64), ys(64);
+	int tested = 0;
+
+	for (int set = ImageTracer::KernelSet_SSE2; set < ImageTracer::KernelSet_Count; ++set)
+	{
+		if (!ImageTracer::Kernels::Supported((ImageTracer::KernelSet)set))
+			continue;
+		const ImageTracer::Kernels::LineErrorsFunc line = ImageTracer::Kernels::LineErrors((ImageTracer::KernelSet)set);
+		const ImageTracer::Kernels::SplineErrorsFunc spline = ImageTracer::Kernels::SplineErrors((ImageTracer::KernelSet)set);
+
+		for (int round = 0; round < 200; ++round)
+		{
+			// Every other round all points are same, so all of them are tied for largest distance.
+			// Otherwise only a few distinct points, so ties are likely as well.
+			const bool same = (round % 2) == 0;
+			const int spread = same ? 1 : 1 + (round % 7);
+			const int px = _Next(seed) % 40, py = _Next(seed) % 40;
+			for (int k = 0; k < (int)xs.size(); ++k)
+			{
+				xs[k] = px + (same ? 0 : _Next(seed) % spread);
+				ys[k] = py + (same ? 0 : _Next(seed) % spread);
+			}
+
+			const float sx = (float)(_Next(seed) % 20), sy = (float)(_Next(seed) % 20);
+			const float vx = same ? 0.0f : (float)(_Next(seed) % 9 - 4) * 0.25f;
+			const float vy = same ? 0.0f : (float)(_Next(seed) % 9 - 4) * 0.25f;
+			const float cx = (float)(_Next(seed) % 40), cy = (float)(_Next(seed) % 40);
+			const float threshold = (float)(_Next(seed) % 400);
+
+			for (int count = 0; count <= 37; ++count)
+			{
+				const int i0 = _Next(seed) % 5;
+				const float tl = (float)(i0 + count + 1);
+
+				for (int start = 0; start < 3; ++start)
+				{
+					// Errorval given might be below, at or above all distances
+					float errorval1 = (float)(start * 100), errorval2 = errorval1;
+					int errorindex1 = -7, errorindex2 = -7;
+					const bool fail1 = scalarline(xs.data(), ys.data(), count, i0, sx, sy, vx, vy, threshold, errorval1, errorindex1);
+					const bool fail2 = line(xs.data(), ys.data(), count, i0, sx, sy, vx, vy, threshold, errorval2, errorindex2);
+					CHECK(fail1 == fail2);
+					CHECK(memcmp(&errorval1, &errorval2, sizeof(float)) == 0);
+					CHECK(errorindex1 == errorindex2);
+					++tested;
+
+					// First of all points tied wins
+					if (same && (count > 0) && (errorindex1 >= 0))
+						CHECK(errorindex2 == i0);
+				}
+
+				CHECK(scalarspline(xs.data(), ys.data(), count, i0, tl, sx, sy, cx, cy, px * 0.5f, py * 0.5f, threshold) ==
+					spline(xs.data(), ys.data(), count, i0, tl, sx, sy, cx, cy, px * 0.5f, py * 0.5f, threshold));
+			}
+		}
+	}
+	printf("Error kernels: %d sequences compared\n", tested);
+}
+
+
+// Layers traced are same as golden ones, colors not found in image don't get a layer
+static void _CheckGolden(const std::vector<byte>& pixels, const int width, const int height, const ImageTracer::Options& options,
+	const int (*layers)[2], const int layer_count, const int* polys, const float (*segments)[7])
+{
+	std::vector<byte> input(pixels);
+	ImageTracer::ImageTracer* tracer = ImageTracer::ImageTracer::Trace(input.data(), width, height, options);
+	CHECK(tracer != nullptr);
+	if (!tracer)
+		return;
+
+	bool present[256] = { false };
+	for (auto p : pixels)
+		present[p] = true;
+	for (auto& layer : tracer->Layers)
+		CHECK(present[layer.ColorIndex]);
+
+	CHECK((int)tracer->Layers.size() == layer_count);
+	if ((int)tracer->Layers.size() == layer_count)
+	{
+		int poly = 0, segment = 0;
+		for (int l = 0; l < layer_count; ++l)
+		{
+			const ImageTracer::Layer& layer = tracer->Layers[l];
+			CHECK(layer.ColorIndex == layers[l][0]);
+			CHECK((int)layer.Polygons.size() == layers[l][1]);
+			if ((layer.ColorIndex != layers[l][0]) || ((int)layer.Polygons.size() != layers[l][1]))
+				break;
+
+			for (auto& p : layer.Polygons)
+			{
+				CHECK((int)p.Segments.size() == polys[poly]);
+				if ((int)p.Segments.size() != polys[poly])
+					break;
+				++poly;
+
+				for (auto& s : p.Segments)
+				{
+					const float* expected = segments[segment++];
+					CHECK((int)s.type == (int)expected[0]);
+					CHECK((s.x1 == expected[1]) && (s.y1 == expected[2]));
+					CHECK((s.x2 == expected[3]) && (s.y2 == expected[4]));
+					CHECK((s.x3 == expected[5]) && (s.y3 == expected[6]));
+				}
+			}
+		}
+	}
+	delete tracer;
+}
+
+// Results of plain tracing are same as those of the original implementation, with layers 
+// traced in parallel as well as one after another with their paths traced in parallel
+static void _TestGolden()
+{
+#ifdef _OPENMP
+	const int threads = omp_get_max_threads();
+	for (int n : { 1, 8 })
+	{
+		omp_set_num_threads(n);
+#endif
+
+		std::vector<byte> pixels;
+		_FixturePixels(_fixture_shapes, 20, 14, pixels);
+		_CheckGolden(pixels, 20, 14, ImageTracer::Options(), _golden_shapes_layers, 
+			sizeof(_golden_shapes_layers) / sizeof(_golden_shapes_layers[0]), _golden_shapes_polys, _golden_shapes_segments);
+
+		_FixtureDiscs(pixels);
+		_CheckGolden(pixels, 64, 48, _FixtureDiscsOptions(), _golden_discs_layers, 
+			sizeof(_golden_discs_layers) / sizeof(_golden_discs_layers[0]), _golden_discs_polys, _golden_discs_segments);
+
+#ifdef _OPENMP
+	}
+	omp_set_num_threads(threads);
+#endif
+}
+
+
+// Load balance only reflects layer loop, which runs on a single thread if paths are traced
+// in parallel, so it's not measured then
+static void _TestStats()
+{
+#ifdef _OPENMP
+	const int threads = omp_get_max_threads();
+	omp_set_num_threads(8);
+
+	// Background and a single disc: fewer colors than threads
+	std::vector<byte> pixels(200 * 150, 0);
+	for (int y = 40; y < 110; ++y)
+		for (int x = 50; x < 150; ++x)
+			pixels[y * 200 + x] = 1;
+
+	ImageTracer::ImageTracer* tracer = ImageTracer::ImageTracer::Trace(pixels.data(), 200, 150, ImageTracer::Options());
+	CHECK(tracer != nullptr);
+	if (tracer)
+	{
+		CHECK(tracer->Stats.ParallelPaths);
+		CHECK(tracer->Stats.Threads == 1);
+		CHECK(tracer->Stats.LoadBalance < 0);
+		delete tracer;
+	}
+
+	// Enough colors for all threads
+	_FillImage(pixels, 200, 150, 7);
+	for (int k = 0; k < 200 * 150; k += 97)
+		pixels[k] = (byte)(6 + k % 5);
+	tracer = ImageTracer::ImageTracer::Trace(pixels.data(), 200, 150, ImageTracer::Options());
+	CHECK(tracer != nullptr);
+	if (tracer)
+	{
+		CHECK(!tracer->Stats.ParallelPaths);
+		CHECK(tracer->Stats.Threads == 8);
+		CHECK((tracer->Stats.LoadBalance > 0) && (tracer->Stats.LoadBalance <= 1.0));
+		delete tracer;
+	}
+
+	omp_set_num_threads(threads);
+#endif
+}
+
+
+// Flat results written while tracing are same as nested ones converted afterwards, whether 
+// layers are traced one after another or in parallel
+static void _TestFlat()
+{
+#ifdef _OPENMP
+	const int threads = omp_get_max_threads();
+	for (int n : { 1, 4, 8 })
+	{
+		omp_set_num_threads(n);
+#endif
+
+		for (int colors : { 2, 6, 11 })
+		{
+			std::vector<byte> pixels;
+			_FillImage(pixels, 200, 150, 11);
+			for (int k = 0; k < 200 * 150; ++k)
+			{
+				if (colors < 6)
+					pixels[k] = (byte)(pixels[k] % colors);
+				else if ((colors > 6) && (k % 97 == 0))
+					pixels[k] = (byte)(6 + k % (colors - 6));
+			}
+
+			ImageTracer::ImageTracer* tracer = ImageTracer::ImageTracer::Trace(pixels.data(), 200, 150, ImageTracer::Options());
+			ImageTracer::FlatResult* flat = ImageTracer::ImageTracer::TraceFlat(pixels.data(), 200, 150, ImageTracer::Options());
+			CHECK(tracer != nullptr);
+			CHECK(flat != nullptr);
+			if (tracer && flat)
+			{
+				CHECK((int)flat->LayerColors.size() == colors);
+				CHECK(_SameResults(ImageTracer::FlatResult(tracer->Layers), *flat));
+			}
+			delete tracer;
+			delete flat;
+		}
+
+#ifdef _OPENMP
+	}
+	omp_set_num_threads(threads);
+#endif
+
+	// Nothing to trace
+	std::vector<byte> pixels(50 * 40, 3);
+	CHECK(ImageTracer::ImageTracer::TraceFlat(pixels.data(), 50, 40, ImageTracer::Options()) == nullptr);
+}
+
+
+// Layers split into stripes when traced by several threads yield same results as traced by a
+// single one, also for heights not split evenly
+static void _TestStripes()
+{
+#ifdef _OPENMP
+	const int threads = omp_get_max_threads();
+	const int sizes[][2] = { { 640, 601 }, { 333, 1031 }, { 1000, 517 } };
+
+	for (auto size : sizes)
+	{
+		const int width = size[0], height = size[1];
+
+		// Few colors, so layers are traced one after another, and lots of noise, so each of
+		// them has enough edge nodes for stripes
+		std::vector<byte> pixels;
+		unsigned int seed = width + height;
+		_FillImage(pixels, width, height, seed, 2000);
+		for (auto& p : pixels)
+			p = (byte)((_Next(seed) % 3 == 0) ? _Next(seed) % 3 : p % 3);
+
+		omp_set_num_threads(1);
+		ImageTracer::ImageTracer* single = ImageTracer::ImageTracer::Trace(pixels.data(), width, height, ImageTracer::Options());
+		CHECK(single != nullptr);
+
+		// Stripe counts of 8 and 14 don't divide these heights
+		for (int n : { 4, 7 })
+		{
+			omp_set_num_threads(n);
+			ImageTracer::ImageTracer* striped = ImageTracer::ImageTracer::Trace(pixels.data(), width, height, ImageTracer::Options());
+			CHECK(striped != nullptr);
+			if (single && striped)
+			{
+				CHECK(striped->Stats.ParallelPaths);
+				CHECK(_SameResults(single->Layers, striped->Layers));
+			}
+			delete striped;
+		}
+		delete single;
+	}
+
+	omp_set_num_threads(threads);
+#endif
+}
+
+
+// Streams rows of pixels given to TraceStream in bands, collects polygons by color index
+static bool _TraceStream(const std::vector<byte>& pixels, const int width, const int height, const int bandrows, std::vector<ImageTracer::PolyList>& polys)
+{
+	int y = 0;
+	polys.assign(256, ImageTracer::PolyList());
+	return ImageTracer::ImageTracer::TraceStream(
+		width,
+		[&](byte* rows, const int count)
+		{
+			const int n = std::min(count, height - y);
+			memcpy(rows, pixels.data() + (size_t)y * width, (size_t)n * width);
+			y += n;
+			return n;
+		},
+		[&](const int color_index, ImageTracer::Poly& poly) { polys[color_index].push_back(std::move(poly)); },
+		ImageTracer::Options(),
+		bandrows);
+}
+
+// Streamed polygons are same as traced ones once sorted by start cell, hole children
+// aside. Failures after earlier bands leave sink with their polygons.
+static void _TestStream()
+{
+	const int sizes[][2] = { { 200, 150 }, { 97, 211 }, { 1, 40 }, { 64, 1 } };
+	std::vector<ImageTracer::PolyList> polys;
+
+	for (auto size : sizes)
+	{
+		const int width = size[0], height = size[1];
+		std::vector<byte> pixels;
+		_FillImage(pixels, width, height, width * height, 100);
+		pixels[0] = 1;
+		pixels[pixels.size() - 1] = 2;
+
+		ImageTracer::ImageTracer* tracer = ImageTracer::ImageTracer::Trace(pixels.data(), width, height, ImageTracer::Options());
+		CHECK(tracer != nullptr);
+		if (!tracer)
+			continue;
+
+		ImageTracer::LayerList expected = tracer->Layers;
+		for (auto& layer : expected)
+		{
+			for (auto& poly : layer.Polygons)
+				poly.HoleChildren.clear();
+		}
+		delete tracer;
+
+		for (int bandrows : { 1, 7, 64 })
+		{
+			CHECK(_TraceStream(pixels, width, height, bandrows, polys));
+
+			ImageTracer::LayerList streamed;
+			size_t count = 0;
+			for (auto& layer : expected)
+			{
+				ImageTracer::PolyList& list = polys[layer.ColorIndex];
+				std::sort(list.begin(), list.end(), [](const ImageTracer::Poly& a, const ImageTracer::Poly& b)
+				{
+					return (a.StartY < b.StartY) || ((a.StartY == b.StartY) && (a.StartX < b.StartX));
+				});
+				count += list.size();
+				streamed.push_back(ImageTracer::Layer(list, layer.ColorIndex));
+			}
+
+			// No polygons of colors missing from traced layers
+			size_t total = 0;
+			for (auto& list : polys)
+				total += list.size();
+			CHECK(total == count);
+			CHECK(_SameResults(expected, streamed));
+		}
+	}
+
+	// Square closed within first band, color index 255 only in last one
+	std::vector<byte> pixels(50 * 70, 1);
+	for (int y = 2; y < 6; ++y)
+		for (int x = 10; x < 20; ++x)
+			pixels[y * 50 + x] = 2;
+	pixels[65 * 50 + 5] = 255;
+	CHECK(!_TraceStream(pixels, 50, 70, 16, polys));
+	CHECK(polys[2].size() == 1);
+
+	// Single color: Rejected without anything passed to sink
+	std::fill(pixels.begin(), pixels.end(), 3);
+	CHECK(!_TraceStream(pixels, 50, 70, 16, polys));
+	for (auto& list : polys)
+		CHECK(list.empty());
+}
+
+
+// Results saved are read back as they were, corrupt files are rejected
+static void _TestResultFile()
+{
+	const wchar_t* filename = L"ImageTracerTest.itr";
+
+	std::vector<byte> pixels;
+	_FillImage(pixels, 300, 200, 9);
+	ImageTracer::FlatResult* flat = ImageTracer::ImageTracer::TraceFlat(pixels.data(), 300, 200, ImageTracer::Options());
+	CHECK(flat != nullptr);
+	if (!flat)
+		return;
+	CHECK(!flat->HoleChildren.empty());
+
+	// Save -> Open -> ToResult
+	CHECK(ImageTracer::ResultFile::Save(*flat, filename));
+	ImageTracer::ResultView* view = ImageTracer::ResultView::Open(filename);
+	CHECK(view != nullptr);
+	if (view)
+	{
+		CHECK(view->LayerCount() == (int)flat->LayerColors.size());
+		CHECK(view->PolyCount() == (int)flat->PolyHoles.size());
+		CHECK(view->SegmentCount() == (int)flat->Segments.size());
+		ImageTracer::FlatResult* copy = view->ToResult();
+		CHECK(copy != nullptr);
+		if (copy)
+			CHECK(_SameResults(*flat, *copy));
+		delete copy;
+		delete view;
+	}
+
+	// Written to 8-byte aligned memory, so headers and arrays can be changed in place
+	const size_t size = ImageTracer::ResultFile::Size(*flat);
+	std::vector<unsigned long long> storage((size + 7) / 8);
+	byte* data = (byte*)storage.data();
+	ImageTracer::ResultFile::Write(*flat, data);
+	ImageTracer::ResultHeader* header = (ImageTracer::ResultHeader*)data;
+	const ImageTracer::ResultHeader original = *header;
+	int* children = (int*)(data + header->sections[ImageTracer::ResultHeader::Section_HoleChildren]);
+	int* polyoffsets = (int*)(data + header->sections[ImageTracer::ResultHeader::Section_PolyOffsets]);
+
+	// Stores data given to file, expecting it to be rejected
+	auto rejected = [&](const size_t bytes)
+	{
+		if (!ImageTracer::ResultFile::SaveData(data, bytes, filename))
+			return false;
+		ImageTracer::ResultView* corrupt = ImageTracer::ResultView::Open(filename);
+		delete corrupt;
+		return (corrupt == nullptr) && (ImageTracer::ResultView::FromMemory(data, bytes) == nullptr);
+	};
+
+	// Unchanged data is fine, truncated data isn't
+	CHECK(!rejected(size));
+	CHECK(rejected(size - 8));
+	CHECK(rejected(sizeof(ImageTracer::ResultHeader) - 1));
+	CHECK(rejected(0));
+
+	// Sections misaligned, before header, beyond end of data or running past it
+	header->sections[ImageTracer::ResultHeader::Section_PolyHoles] += 4;
+	CHECK(rejected(size));
+	*header = original;
+	header->sections[ImageTracer::ResultHeader::Section_LayerColors] = 0;
+	CHECK(rejected(size));
+	*header = original;
+	header->sections[ImageTracer::ResultHeader::Section_Segments] = size + 8;
+	CHECK(rejected(size));
+	*header = original;
+	header->segmentcount += 1000;
+	CHECK(rejected(size));
+	*header = original;
+	header->layercount = 0x80000000u;
+	CHECK(rejected(size));
+	*header = original;
+	header->version = ImageTracer::ResultFormatVersion + 1;
+	CHECK(rejected(size));
+	*header = original;
+
+	// Offset table decreasing
+	std::swap(polyoffsets[1], polyoffsets[2]);
+	CHECK(rejected(size));
+	std::swap(polyoffsets[1], polyoffsets[2]);
+
+	// Hole child out of range of its layer's polys
+	const int child = children[0];
+	children[0] = (int)original.polycount;
+	CHECK(rejected(size));
+	children[0] = -1;
+	CHECK(rejected(size));
+	children[0] = child;
+	CHECK(!rejected(size));
+
+	// Missing files are no valid results either
+	_wremove(filename);
+	CHECK(ImageTracer::ResultView::Open(filename) == nullptr);
+
+	delete flat;
+}
+
+
+// Hits, misses and evictions are counted, least recently used results are dropped first,
+// results stored are found by other caches unless their pixels differ
+static void _TestCache()
+{
+	std::vector<byte> images[3];
+	std::shared_ptr<const ImageTracer::FlatResult> expected[3];
+	size_t sizes[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		_FillImage(images[i], 160, 120, 100 + i, 60);
+		ImageTracer::FlatResult* flat = ImageTracer::ImageTracer::TraceFlat(images[i].data(), 160, 120, ImageTracer::Options());
+		CHECK(flat != nullptr);
+		if (!flat)
+			return;
+		expected[i].reset(flat);
+		sizes[i] = ImageTracer::ResultFile::Size(*flat);
+	}
+
+	// Room for any two results, but not all three
+	ImageTracer::TraceCache cache(sizes[0] + sizes[1] + sizes[2] - 1);
+	auto trace = [&](ImageTracer::TraceCache& c, const int i)
+	{
+		std::shared_ptr<const ImageTracer::FlatResult> result = c.Trace(images[i].data(), 160, 120, ImageTracer::Options());
+		CHECK(result != nullptr);
+		if (result)
+			CHECK(_SameResults(*result, *expected[i]));
+		return result;
+	};
+
+	trace(cache, 0);
+	trace(cache, 1);
+	CHECK((cache.Stats.Misses == 2) && (cache.Stats.Hits == 0));
+
+	// 0 used more recently than 1, so adding 2 drops 1
+	trace(cache, 0);
+	CHECK(cache.Stats.Hits == 1);
+	trace(cache, 2);
+	CHECK((cache.Stats.Misses == 3) && (cache.Stats.Evictions == 1));
+	trace(cache, 0);
+	trace(cache, 2);
+	CHECK((cache.Stats.Hits == 3) && (cache.Stats.Misses == 3));
+	trace(cache, 1);
+	CHECK((cache.Stats.Misses == 4) && (cache.Stats.Evictions == 2));
+
+	// Options are part of key
+	ImageTracer::Options options;
+	options.pathomit = 0;
+	CHECK(cache.Trace(images[2].data(), 160, 120, options) != nullptr);
+	CHECK(cache.Stats.Misses == 5);
+
+	cache.Clear();
+	trace(cache, 1);
+	CHECK((cache.Stats.Misses == 6) && (cache.Stats.DiskHits == 0));
+
+	// Stored by one cache, found on disk by another, then in its memory
+	const unsigned long long key = ImageTracer::TraceCache::Key(images[0].data(), 160, 120, ImageTracer::Options());
+	wchar_t filename[64];
+	swprintf(filename, sizeof(filename) / sizeof(filename[0]), L".\\%016llx.itr", key);
+	_wremove(filename);
+
+	ImageTracer::TraceCache writer(1 << 20, L".");
+	trace(writer, 0);
+	CHECK(writer.Stats.Misses == 1);
+
+	ImageTracer::TraceCache reader(1 << 20, L".");
+	trace(reader, 0);
+	trace(reader, 0);
+	CHECK((reader.Stats.DiskHits == 1) && (reader.Stats.Hits == 1) && (reader.Stats.Misses == 0));
+
+	// File of pixels having same key but different check hash, which follows magic,
+	// version and key, isn't used
+	FILE* f = _wfopen(filename, L"r+b");
+	CHECK(f != nullptr);
+	if (f)
+	{
+		unsigned long long check = 0;
+		fseek(f, 16, SEEK_SET);
+		CHECK(fread(&check, sizeof(check), 1, f) == 1);
+		check ^= 1;
+		fseek(f, 16, SEEK_SET);
+		fwrite(&check, sizeof(check), 1, f);
+		fclose(f);
+	}
+	ImageTracer::TraceCache other(1 << 20, L".");
+	trace(other, 0);
+	CHECK((other.Stats.DiskHits == 0) && (other.Stats.Misses == 1));
+
+	_wremove(filename);
+}
+
+
+// Fills pixels within rectangle (inclusive coordinates) with a color, a ring of color
+// around another one, or noise
+static void _ChangeRect(std::vector<byte>& pixels, const int width, const ImageTracer::BBox& rect, unsigned int& seed)
+{
+	const int mode = _Next(seed) % 3;
+	const byte color = (byte)(_Next(seed) % 6), inner = (byte)(_Next(seed) % 6);
+	for (int y = rect.coords[1]; y <= rect.coords[3]; ++y)
+	{
+		for (int x = rect.coords[0]; x <= rect.coords[2]; ++x)
+		{
+			const bool edge = (x - rect.coords[0] < 3) || (rect.coords[2] - x < 3) || (y - rect.coords[1] < 3) || (rect.coords[3] - y < 3);
+			byte& p = pixels[y * width + x];
+			if (mode == 0)
+				p = color;
+			else if (mode == 1)
+				p = edge ? color : inner;
+			else if (_Next(seed) % 3 == 0)
+				p = (byte)(_Next(seed) % 6);
+		}
+	}
+}
+
+// Retracing changed rectangles yields same results as tracing whole image again, for 
+// rectangles anywhere including image borders, and ones spanning holes
+static void _TestRetrace()
+{
+	const int width = 200, height = 150;
+	std::vector<byte> pixels;
+	_FillImage(pixels, width, height, 31, 120);
+
+	// Frame of color 1 with a hole of color 2, within image
+	for (int y = 40; y < 110; ++y)
+		for (int x = 50; x < 150; ++x)
+			pixels[y * width + x] = ((x >= 70) && (x < 130) && (y >= 60) && (y < 90)) ? 2 : 1;
+
+	ImageTracer::ImageTracer* previous = ImageTracer::ImageTracer::Trace(pixels.data(), width, height, ImageTracer::Options());
+	CHECK(previous != nullptr);
+	if (!previous)
+		return;
+	ImageTracer::TracerContext context;
+	CHECK(context.Trace(pixels.data(), width, height, ImageTracer::Options()) != nullptr);
+
+	unsigned int seed = 77;
+	for (int round = 0; round < 60; ++round)
+	{
+		ImageTracer::BBox rect;
+		switch (round % 6)
+		{
+		case 0:
+			// Spanning hole of frame, along with parts of frame around it
+			rect = ImageTracer::BBox(60 + _Next(seed) % 8, 50 + _Next(seed) % 8, 135 + _Next(seed) % 8, 95 + _Next(seed) % 8);
+			break;
+		case 1:
+			// Touching left and top borders
+			rect = ImageTracer::BBox(0, 0, _Next(seed) % 40, _Next(seed) % 40);
+			break;
+		case 2:
+			// Touching right and bottom borders
+			rect = ImageTracer::BBox(width - 1 - _Next(seed) % 40, height - 1 - _Next(seed) % 40, width - 1, height - 1);
+			break;
+		case 3:
+			// Spanning all rows or all columns
+			rect = (_Next(seed) % 2) ?
+				ImageTracer::BBox(_Next(seed) % 180, 0, 0, height - 1) :
+				ImageTracer::BBox(0, _Next(seed) % 130, width - 1, 0);
+			rect.coords[2] = std::max(rect.coords[2], rect.coords[0] + _Next(seed) % 20);
+			rect.coords[3] = std::max(rect.coords[3], rect.coords[1] + _Next(seed) % 20);
+			break;
+		case 4:
+			// Single pixel
+			rect.coords[0] = rect.coords[2] = _Next(seed) % width;
+			rect.coords[1] = rect.coords[3] = _Next(seed) % height;
+			break;
+		default:
+			rect.coords[0] = _Next(seed) % width;
+			rect.coords[1] = _Next(seed) % height;
+			rect.coords[2] = std::min(width - 1, rect.coords[0] + _Next(seed) % 60);
+			rect.coords[3] = std::min(height - 1, rect.coords[1] + _Next(seed) % 60);
+			break;
+		}
+		_ChangeRect(pixels, width, rect, seed);
+
+		ImageTracer::ImageTracer* fresh = ImageTracer::ImageTracer::Trace(pixels.data(), width, height, ImageTracer::Options());
+		ImageTracer::ImageTracer* retraced = ImageTracer::ImageTracer::Retrace(*previous, pixels.data(), width, height, rect, ImageTracer::Options());
+		const ImageTracer::ImageTracer* updated = context.Retrace(pixels.data(), width, height, rect, ImageTracer::Options());
+		CHECK(fresh != nullptr);
+		CHECK(retraced != nullptr);
+		CHECK(updated != nullptr);
+		if (fresh && retraced)
+			CHECK(_SameResults(fresh->Layers, retraced->Layers));
+		if (fresh && updated)
+			CHECK(_SameResults(fresh->Layers, updated->Layers));
+
+		// Next round retraces this one's result
+		delete retraced;
+		delete previous;
+		previous = fresh;
+		if (!previous)
+			return;
+	}
+	delete previous;
+}
+
+
+// Frames of a sequence are same as traced on their own. Changed area is found for changes
+// at any image border, frames are traced from scratch once it exceeds half of their area.
+static void _TestSequence()
+{
+	const int width = 200, height = 150;
+	std::vector<byte> pixels;
+	_FillImage(pixels, width, height, 53, 120);
+
+	ImageTracer::SequenceTracer sequence;
+	int frames = 0;
+
+	// Traces next frame, compares it to tracing it on its own
+	auto frame = [&]()
+	{
+		++frames;
+		const ImageTracer::ImageTracer* traced = sequence.TraceFrame(pixels.data(), width, height, ImageTracer::Options());
+		ImageTracer::ImageTracer* fresh = ImageTracer::ImageTracer::Trace(pixels.data(), width, height, ImageTracer::Options());
+		CHECK(traced != nullptr);
+		CHECK(fresh != nullptr);
+		if (traced && fresh)
+			CHECK(_SameResults(fresh->Layers, traced->Layers));
+		delete fresh;
+	};
+	auto changed = [&](const int x0, const int y0, const int x1, const int y1)
+	{
+		const ImageTracer::BBox& area = sequence.Stats.ChangedArea;
+		return (area.coords[0] == x0) && (area.coords[1] == y0) && (area.coords[2] == x1) && (area.coords[3] == y1);
+	};
+
+	frame();
+	CHECK(sequence.Stats.FullTrace);
+	CHECK(changed(0, 0, width - 1, height - 1));
+
+	// Unchanged frame
+	frame();
+	CHECK(!sequence.Stats.FullTrace);
+	CHECK(changed(-1, -1, -1, -1));
+	CHECK(sequence.Stats.LayersReused == sequence.Stats.Layers);
+
+	// Single pixels at each border, others staying same
+	const int pixels1[][2] = { { 0, 70 }, { width - 1, 20 }, { 120, 0 }, { 33, height - 1 }, { 0, 0 }, { width - 1, height - 1 } };
+	for (auto p : pixels1)
+	{
+		byte& pixel = pixels[p[1] * width + p[0]];
+		pixel = (byte)((pixel + 1) % 6);
+		frame();
+		CHECK(!sequence.Stats.FullTrace);
+		CHECK(changed(p[0], p[1], p[0], p[1]));
+	}
+
+	// Pixels at left and right border in different rows, area spanning them
+	pixels[10 * width] = (byte)((pixels[10 * width] + 1) % 6);
+	pixels[15 * width + width - 1] = (byte)((pixels[15 * width + width - 1] + 1) % 6);
+	frame();
+	CHECK(changed(0, 10, width - 1, 15));
+
+	// Changes spanning exactly half of frame are retraced, one more column is traced from scratch
+	unsigned int seed = 5;
+	for (int columns : { width / 2, width / 2 + 1 })
+	{
+		ImageTracer::BBox rect(10, 0, 10 + columns - 1, height - 1);
+		_ChangeRect(pixels, width, rect, seed);
+
+		// Corners of rect changed for sure, so changed area is all of it
+		for (int k = 0; k < 4; ++k)
+		{
+			byte& corner = pixels[rect.coords[1 + (k & 2)] * width + rect.coords[(k & 1) ? 2 : 0]];
+			corner = (byte)((corner + 1) % 6);
+		}
+		frame();
+		CHECK(changed(rect.coords[0], rect.coords[1], rect.coords[2], rect.coords[3]));
+		CHECK(sequence.Stats.FullTrace == (columns > width / 2));
+	}
+
+	// Random changes, frame after frame
+	for (int k = 0; k < 20; ++k)
+	{
+		ImageTracer::BBox rect;
+		rect.coords[0] = _Next(seed) % width;
+		rect.coords[1] = _Next(seed) % height;
+		rect.coords[2] = std::min(width - 1, rect.coords[0] + _Next(seed) % 80);
+		rect.coords[3] = std::min(height - 1, rect.coords[1] + _Next(seed) % 80);
+		_ChangeRect(pixels, width, rect, seed);
+		frame();
+	}
+
+	// Frame of another size starts over
+	std::vector<byte> other;
+	_FillImage(other, 120, 90, 3, 40);
+	CHECK(sequence.TraceFrame(other.data(), 120, 90, ImageTracer::Options()) != nullptr);
+	CHECK(sequence.Stats.FullTrace);
+	frame();
+	CHECK(sequence.Stats.FullTrace);
+
+	printf("Sequence: %d frames compared\n", frames);
+}
+
+
+// Batch results are same as tracing each image on its own, images failing to trace only
+// get nullptr themselves
+static void _TestBatch()
+{
+	const int sizes[][2] = { { 200, 150 }, { 31, 17 }, { 64, 64 }, { 300, 41 }, { 16, 12 }, { 120, 240 }, { 77, 77 } };
+	const int count = sizeof(sizes) / sizeof(sizes[0]);
+	std::vector<std::vector<byte>> pixels(count);
+	for (int i = 0; i < count; ++i)
+	{
+		// Discs might cover all of small images, so there are two colors for sure
+		_FillImage(pixels[i], sizes[i][0], sizes[i][1], 200 + i, 40);
+		pixels[i].front() = 1;
+		pixels[i].back() = 2;
+	}
+
+	// Single color image and one using color index 255, both in the middle of the batch
+	std::fill(pixels[2].begin(), pixels[2].end(), 3);
+	pixels[4][5] = 255;
+
+	ImageTracer::BatchImageList images;
+	for (int i = 0; i < count; ++i)
+		images.push_back(ImageTracer::BatchImage(pixels[i].data(), sizes[i][0], sizes[i][1]));
+
+	std::vector<ImageTracer::ImageTracer*> results = ImageTracer::ImageTracer::TraceBatch(images, ImageTracer::Options());
+	CHECK((int)results.size() == count);
+	if ((int)results.size() != count)
+		return;
+
+	for (int i = 0; i < count; ++i)
+	{
+		ImageTracer::ImageTracer* single = ImageTracer::ImageTracer::Trace(pixels[i].data(), sizes[i][0], sizes[i][1], ImageTracer::Options());
+		CHECK((single == nullptr) == ((i == 2) || (i == 4)));
+		CHECK((results[i] == nullptr) == (single == nullptr));
+		if (single && results[i])
+			CHECK(_SameResults(single->Layers, results[i]->Layers));
+		delete single;
+		delete results[i];
+	}
+}
+
+
+//*****************************************************************************
+
+int main()
+{
+	_TestScanWindows();
+	_TestErrorKernels();
+	_TestGolden();
+	_TestStats();
+	_TestFlat();
+	_TestStripes();
+	_TestStream();
+	_TestRetrace();
+	_TestSequence();
+	_TestBatch();
+	_TestResultFile();
+	_TestCache();
+
+	return _Summary();
+}
@@ -0,0 +1,71 @@
+// TestCommon.h
+//
+// Checks and test images shared by all tests, each test program includes it once.
+
+#pragma once
+
+
+#include "../ImageTracer.h"
+
+
+static int _failed = 0;
+
+#define CHECK(cond) \
+	do { if (!(cond)) { printf("%s(%d): Check failed: %s\n", __FILE__, __LINE__, #cond); ++_failed; } } while (0)
+
+
+// Pseudo random numbers, same on every run and platform
+static int _Next(unsigned int& seed)
+{
+	seed = seed * 1103515245u + 12345u;
+	return (int)((seed >> 8) & 0xFFFF);
+}
+
+// Overlapping discs of 6 colors, pseudo random but same on every run
+static void _FillImage(std::vector<byte>& pixels, const int width, const int height, unsigned int seed, const int discs = 300)
+{
+	pixels.assign((size_t)width * height, 0);
+	for (int k = 0; k < discs; ++k)
+	{
+		const int cx = _Next(seed) % width;
+		const int cy = _Next(seed) % height;
+		const int r = 3 + _Next(seed) % 40;
+		const byte color = (byte)(_Next(seed) % 6);
+		for (int y = std::max(0, cy - r); y < std::min(height, cy + r); ++y)
+		{
+			for (int x = std::max(0, cx - r); x < std::min(width, cx + r); ++x)
+			{
+				if ((x - cx) * (x - cx) + (y - cy) * (y - cy) < r * r)
+					pixels[y * width + x] = color;
+			}
+		}
+	}
+}
+
+static bool _SameResults(const ImageTracer::FlatResult& fa, const ImageTracer::FlatResult& fb)
+{
+	return (fa.LayerColors == fb.LayerColors)
+		&& (fa.LayerOffsets == fb.LayerOffsets)
+		&& (fa.PolyOffsets == fb.PolyOffsets)
+		&& (fa.PolyHoles == fb.PolyHoles)
+		&& (fa.PolyBBoxes == fb.PolyBBoxes)
+		&& (fa.HoleOffsets == fb.HoleOffsets)
+		&& (fa.HoleChildren == fb.HoleChildren)
+		&& (fa.Segments.size() == fb.Segments.size())
+		&& (memcmp(fa.Segments.data(), fb.Segments.data(), fa.Segments.size() * sizeof(ImageTracer::Segment)) == 0);
+}
+
+static bool _SameResults(const ImageTracer::LayerList& a, const ImageTracer::LayerList& b)
+{
+	return _SameResults(ImageTracer::FlatResult(a), ImageTracer::FlatResult(b));
+}
+
+// Prints summary, returns exit code
+static int _Summary()
+{
+	if (_failed)
+		printf("%d check(s) failed\n", _failed);
+	else
+		printf("All checks passed\n");
+	return _failed;
+}
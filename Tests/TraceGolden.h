@@ -0,0 +1,486 @@
+// TraceGolden.h
+//
+// Fixture images and their results as traced by the original implementation, which
+// traced each color index on its own with an int per cell. Layers are listed in order of
+// color index, only colors found in image are listed. Segments are type, then x1, y1,
+// x2, y2, x3, y3, being exact as fitting is compiled w/o contracting float operations.
+// Included once by ImageTracerTest.cpp, after TestCommon.h.
+
+#pragma once
+
+
+// Small images with holes, nested shapes, diagonals, saddle cells and specks shorter than
+// pathomit. Digits are color indices, color 2 is not used.
+static const char* _fixture_shapes[] = {
+	"00000000000000000000",
+	"01111111111000033300",
+	"01111111111000333330",
+	"01100000011003333333",
+	"01103330011000333330",
+	"01103330011000033300",
+	"01100000011000000000",
+	"01111111111030303030",
+	"01111111111303030303",
+	"00000000000030303030",
+	"03333000111000000000",
+	"03003001101100111110",
+	"03333000111000100010",
+	"00000000000000111110",
+};
+
+static void _FixturePixels(const char** rows, const int width, const int height, std::vector<byte>& pixels)
+{
+	pixels.resize((size_t)width * height);
+	for (int y = 0; y < height; ++y)
+		for (int x = 0; x < width; ++x)
+			pixels[y * width + x] = (byte)(rows[y][x] - '0');
+}
+
+// Discs with specks, even color indices only, traced with other options
+static void _FixtureDiscs(std::vector<byte>& pixels)
+{
+	_FillImage(pixels, 64, 48, 5, 60);
+	for (int k = 0; k < 64 * 48; k += 41)
+		pixels[k] = (byte)(k % 7);
+	for (auto& p : pixels)
+		p = (byte)(2 * p);
+}
+
+static ImageTracer::Options _FixtureDiscsOptions()
+{
+	ImageTracer::Options options;
+	options.ltres = 0.5f;
+	options.qtres = 0.5f;
+	options.pathomit = 0;
+	options.rightangleenhance = false;
+	return options;
+}
+
+
+// _fixture_shapes (20 x 14) traced with default options: color index and poly count per
+// layer, segment count per poly, segments
+static const int _golden_shapes_layers[][2] = {
+	{ 0, 7 },
+	{ 1, 5 },
+	{ 3, 4 },
+};
+
+static const int _golden_shapes_polys[] = {
+	14, 5, 4, 2, 2, 3, 3, 4, 4, 3, 4, 3, 3, 2, 6, 2,
+};
+
+static const float _golden_shapes_segments[][7] = {
+	{ 0, 0.0f, 0.0f, 19.5f, 0.0f, 0.0f, 0.0f },
+	{ 0, 19.5f, 0.0f, 20.0f, 2.5f, 0.0f, 0.0f },
+	{ 0, 20.0f, 2.5f, 17.5f, 1.0f, 0.0f, 0.0f },
+	{ 1, 17.5f, 1.0f, 13.4999981f, 0.50000006f, 13.0f, 3.5f },
+	{ 1, 13.0f, 3.5f, 13.500001f, 6.50000048f, 17.5f, 6.0f },
+	{ 0, 17.5f, 6.0f, 20.0f, 4.5f, 0.0f, 0.0f },
+	{ 0, 20.0f, 4.5f, 19.0f, 8.5f, 0.0f, 0.0f },
+	{ 0, 19.0f, 8.5f, 20.0f, 13.5f, 0.0f, 0.0f },
+	{ 0, 20.0f, 13.5f, 19.0f, 13.5f, 0.0f, 0.0f },
+	{ 0, 19.0f, 13.5f, 19.0f, 11.0f, 0.0f, 0.0f },
+	{ 0, 19.0f, 11.0f, 14.0f, 11.0f, 0.0f, 0.0f },
+	{ 0, 14.0f, 11.0f, 13.5f, 14.0f, 0.0f, 0.0f },
+	{ 0, 13.5f, 14.0f, 0.0f, 14.0f, 0.0f, 0.0f },
+	{ 0, 0.0f, 14.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+	{ 0, 1.0f, 1.0f, 11.0f, 1.0f, 0.0f, 0.0f },
+	{ 0, 11.0f, 1.0f, 11.0f, 7.5f, 0.0f, 0.0f },
+	{ 0, 11.0f, 7.5f, 11.5f, 9.0f, 0.0f, 0.0f },
+	{ 0, 11.5f, 9.0f, 1.0f, 9.0f, 0.0f, 0.0f },
+	{ 0, 1.0f, 9.0f, 1.0f, 1.0f, 0.0f, 0.0f },
+	{ 0, 3.0f, 3.0f, 9.0f, 3.0f, 0.0f, 0.0f },
+	{ 0, 9.0f, 3.0f, 9.0f, 7.0f, 0.0f, 0.0f },
+	{ 0, 9.0f, 7.0f, 3.0f, 7.0f, 0.0f, 0.0f },
+	{ 0, 3.0f, 7.0f, 3.0f, 3.0f, 0.0f, 0.0f },
+	{ 1, 4.0f, 4.0f, 8.125f, 2.66666627f, 7.0f, 6.0f },
+	{ 1, 7.0f, 6.0f, 2.875f, 7.33333349f, 4.0f, 4.0f },
+	{ 1, 1.0f, 10.0f, 6.5999999f, 8.125f, 5.0f, 13.0f },
+	{ 1, 5.0f, 13.0f, -0.599999905f, 14.875f, 1.0f, 10.0f },
+	{ 0, 8.5f, 10.0f, 12.0f, 11.5f, 0.0f, 0.0f },
+	{ 0, 12.0f, 11.5f, 8.5f, 13.0f, 0.0f, 0.0f },
+	{ 1, 8.5f, 13.0f, 5.5f, 11.5f, 8.5f, 10.0f },
+	{ 0, 15.5f, 12.0f, 18.0f, 12.5f, 0.0f, 0.0f },
+	{ 0, 18.0f, 12.5f, 15.5f, 13.0f, 0.0f, 0.0f },
+	{ 0, 15.5f, 13.0f, 15.5f, 12.0f, 0.0f, 0.0f },
+	{ 0, 1.0f, 1.0f, 11.0f, 1.0f, 0.0f, 0.0f },
+	{ 0, 11.0f, 1.0f, 11.0f, 9.0f, 0.0f, 0.0f },
+	{ 0, 11.0f, 9.0f, 1.0f, 9.0f, 0.0f, 0.0f },
+	{ 0, 1.0f, 9.0f, 1.0f, 1.0f, 0.0f, 0.0f },
+	{ 0, 3.0f, 3.0f, 9.0f, 3.0f, 0.0f, 0.0f },
+	{ 0, 9.0f, 3.0f, 9.0f, 7.0f, 0.0f, 0.0f },
+	{ 0, 9.0f, 7.0f, 3.0f, 7.0f, 0.0f, 0.0f },
+	{ 0, 3.0f, 7.0f, 3.0f, 3.0f, 0.0f, 0.0f },
+	{ 0, 8.5f, 10.0f, 12.0f, 11.5f, 0.0f, 0.0f },
+	{ 0, 12.0f, 11.5f, 8.5f, 13.0f, 0.0f, 0.0f },
+	{ 1, 8.5f, 13.0f, 5.5f, 11.5f, 8.5f, 10.0f },
+	{ 0, 14.0f, 11.0f, 19.0f, 11.0f, 0.0f, 0.0f },
+	{ 0, 19.0f, 11.0f, 19.0f, 14.0f, 0.0f, 0.0f },
+	{ 0, 19.0f, 14.0f, 14.0f, 14.0f, 0.0f, 0.0f },
+	{ 0, 14.0f, 14.0f, 14.0f, 11.0f, 0.0f, 0.0f },
+	{ 0, 15.5f, 12.0f, 18.0f, 12.5f, 0.0f, 0.0f },
+	{ 0, 18.0f, 12.5f, 15.5f, 13.0f, 0.0f, 0.0f },
+	{ 0, 15.5f, 13.0f, 15.5f, 12.0f, 0.0f, 0.0f },
+	{ 1, 15.5f, 1.0f, 19.5f, 0.50000006f, 20.0f, 3.5f },
+	{ 1, 20.0f, 3.5f, 19.5f, 6.50000048f, 15.5f, 6.0f },
+	{ 1, 15.5f, 6.0f, 10.5f, 3.5f, 15.5f, 1.0f },
+	{ 1, 4.0f, 4.0f, 8.125f, 2.66666627f, 7.0f, 6.0f },
+	{ 1, 7.0f, 6.0f, 2.875f, 7.33333349f, 4.0f, 4.0f },
+	{ 0, 12.5f, 7.0f, 18.5f, 7.0f, 0.0f, 0.0f },
+	{ 0, 18.5f, 7.0f, 20.0f, 8.5f, 0.0f, 0.0f },
+	{ 0, 20.0f, 8.5f, 18.5f, 10.0f, 0.0f, 0.0f },
+	{ 0, 18.5f, 10.0f, 12.5f, 10.0f, 0.0f, 0.0f },
+	{ 0, 12.5f, 10.0f, 11.0f, 8.5f, 0.0f, 0.0f },
+	{ 0, 11.0f, 8.5f, 12.5f, 7.0f, 0.0f, 0.0f },
+	{ 1, 1.0f, 10.0f, 6.5999999f, 8.125f, 5.0f, 13.0f },
+	{ 1, 5.0f, 13.0f, -0.599999905f, 14.875f, 1.0f, 10.0f },
+};
+
+// _FixtureDiscs (64 x 48) traced with _FixtureDiscsOptions
+static const int _golden_discs_layers[][2] = {
+	{ 0, 17 },
+	{ 2, 46 },
+	{ 4, 14 },
+	{ 6, 13 },
+	{ 8, 15 },
+	{ 10, 12 },
+	{ 12, 11 },
+};
+
+static const int _golden_discs_polys[] = {
+	3, 2, 12, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 33, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 8,
+	2, 2, 2, 2, 2, 2, 5, 2, 2, 2, 2, 2, 2, 10, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	8, 2, 2, 2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 4, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+};
+
+static const float _golden_discs_segments[][7] = {
+	{ 0, 0.5f, 0.0f, 5.0f, 0.5f, 0.0f, 0.0f },
+	{ 0, 5.0f, 0.5f, 0.5f, 3.0f, 0.0f, 0.0f },
+	{ 0, 0.5f, 3.0f, 0.5f, 0.0f, 0.0f, 0.0f },
+	{ 0, 31.5f, 4.0f, 31.5f, 5.0f, 0.0f, 0.0f },
+	{ 0, 31.5f, 5.0f, 31.5f, 4.0f, 0.0f, 0.0f },
+	{ 0, 47.5f, 6.0f, 55.5f, 6.0f, 0.0f, 0.0f },
+	{ 0, 55.5f, 6.0f, 60.0f, 10.5f, 0.0f, 0.0f },
+	{ 0, 60.0f, 10.5f, 60.0f, 16.5f, 0.0f, 0.0f },
+	{ 0, 60.0f, 16.5f, 61.0f, 17.5f, 0.0f, 0.0f },
+	{ 0, 61.0f, 17.5f, 55.5f, 23.0f, 0.0f, 0.0f },
+	{ 0, 55.5f, 23.0f, 48.5f, 23.0f, 0.0f, 0.0f },
+	{ 0, 48.5f, 23.0f, 47.0f, 24.5f, 0.0f, 0.0f },
+	{ 1, 47.0f, 24.5f, 46.125f, 29.1250019f, 42.5f, 31.0f },
+	{ 0, 42.5f, 31.0f, 42.0f, 19.5f, 0.0f, 0.0f },
+	{ 0, 42.0f, 19.5f, 43.0f, 18.5f, 0.0f, 0.0f },
+	{ 0, 43.0f, 18.5f, 43.0f, 10.5f, 0.0f, 0.0f },
+	{ 0, 43.0f, 10.5f, 47.5f, 6.0f, 0.0f, 0.0f },
+	{ 0, 62.5f, 8.0f, 62.5f, 9.0f, 0.0f, 0.0f },
+	{ 0, 62.5f, 9.0f, 62.5f, 8.0f, 0.0f, 0.0f },
+	{ 0, 57.5f, 10.0f, 57.5f, 11.0f, 0.0f, 0.0f },
+	{ 0, 57.5f, 11.0f, 57.5f, 10.0f, 0.0f, 0.0f },
+	{ 0, 52.5f, 12.0f, 52.5f, 13.0f, 0.0f, 0.0f },
+	{ 0, 52.5f, 13.0f, 52.5f, 12.0f, 0.0f, 0.0f },
+	{ 0, 29.5f, 13.0f, 29.5f, 14.0f, 0.0f, 0.0f },
+	{ 0, 29.5f, 14.0f, 29.5f, 13.0f, 0.0f, 0.0f },
+	{ 0, 47.5f, 14.0f, 47.5f, 15.0f, 0.0f, 0.0f },
+	{ 0, 47.5f, 15.0f, 47.5f, 14.0f, 0.0f, 0.0f },
+	{ 0, 55.5f, 19.0f, 55.5f, 20.0f, 0.0f, 0.0f },
+	{ 0, 55.5f, 20.0f, 55.5f, 19.0f, 0.0f, 0.0f },
+	{ 0, 50.5f, 21.0f, 50.5f, 22.0f, 0.0f, 0.0f },
+	{ 0, 50.5f, 22.0f, 50.5f, 21.0f, 0.0f, 0.0f },
+	{ 0, 27.5f, 22.0f, 27.5f, 23.0f, 0.0f, 0.0f },
+	{ 0, 27.5f, 23.0f, 27.5f, 22.0f, 0.0f, 0.0f },
+	{ 0, 45.5f, 23.0f, 45.5f, 24.0f, 0.0f, 0.0f },
+	{ 0, 45.5f, 24.0f, 45.5f, 23.0f, 0.0f, 0.0f },
+	{ 0, 58.5f, 26.0f, 58.5f, 27.0f, 0.0f, 0.0f },
+	{ 0, 58.5f, 27.0f, 58.5f, 26.0f, 0.0f, 0.0f },
+	{ 0, 25.5f, 31.0f, 25.5f, 32.0f, 0.0f, 0.0f },
+	{ 0, 25.5f, 32.0f, 25.5f, 31.0f, 0.0f, 0.0f },
+	{ 0, 56.5f, 35.0f, 56.5f, 36.0f, 0.0f, 0.0f },
+	{ 0, 56.5f, 36.0f, 56.5f, 35.0f, 0.0f, 0.0f },
+	{ 0, 23.5f, 40.0f, 23.5f, 41.0f, 0.0f, 0.0f },
+	{ 0, 23.5f, 41.0f, 23.5f, 40.0f, 0.0f, 0.0f },
+	{ 0, 54.5f, 44.0f, 54.5f, 45.0f, 0.0f, 0.0f },
+	{ 0, 54.5f, 45.0f, 54.5f, 44.0f, 0.0f, 0.0f },
+	{ 0, 5.5f, 0.0f, 26.0f, 0.5f, 0.0f, 0.0f },
+	{ 0, 26.0f, 0.5f, 26.0f, 7.5f, 0.0f, 0.0f },
+	{ 0, 26.0f, 7.5f, 30.5f, 13.0f, 0.0f, 0.0f },
+	{ 0, 30.5f, 13.0f, 38.0f, 14.5f, 0.0f, 0.0f },
+	{ 0, 38.0f, 14.5f, 39.5f, 17.0f, 0.0f, 0.0f },
+	{ 0, 39.5f, 17.0f, 42.0f, 18.5f, 0.0f, 0.0f },
+	{ 0, 42.0f, 18.5f, 42.0f, 39.5f, 0.0f, 0.0f },
+	{ 0, 42.0f, 39.5f, 46.5f, 44.0f, 0.0f, 0.0f },
+	{ 0, 46.5f, 44.0f, 53.5f, 44.0f, 0.0f, 0.0f },
+	{ 0, 53.5f, 44.0f, 54.5f, 45.0f, 0.0f, 0.0f },
+	{ 0, 54.5f, 45.0f, 59.0f, 39.5f, 0.0f, 0.0f },
+	{ 0, 59.0f, 39.5f, 59.0f, 31.5f, 0.0f, 0.0f },
+	{ 0, 59.0f, 31.5f, 54.5f, 27.0f, 0.0f, 0.0f },
+	{ 0, 54.5f, 27.0f, 46.0f, 26.5f, 0.0f, 0.0f },
+	{ 0, 46.0f, 26.5f, 48.5f, 23.0f, 0.0f, 0.0f },
+	{ 0, 48.5f, 23.0f, 55.5f, 23.0f, 0.0f, 0.0f },
+	{ 0, 55.5f, 23.0f, 61.0f, 17.5f, 0.0f, 0.0f },
+	{ 1, 61.0f, 17.5f, 59.0f, 16.5f, 61.0f, 15.5f },
+	{ 0, 61.0f, 15.5f, 63.5f, 11.0f, 0.0f, 0.0f },
+	{ 0, 63.5f, 11.0f, 64.0f, 23.5f, 0.0f, 0.0f },
+	{ 1, 64.0f, 23.5f, 62.0f, 24.5f, 64.0f, 25.5f },
+	{ 0, 64.0f, 25.5f, 63.5f, 48.0f, 0.0f, 0.0f },
+	{ 0, 63.5f, 48.0f, 37.5f, 48.0f, 0.0f, 0.0f },
+	{ 0, 37.5f, 48.0f, 36.0f, 46.5f, 0.0f, 0.0f },
+	{ 0, 36.0f, 46.5f, 35.5f, 44.0f, 0.0f, 0.0f },
+	{ 0, 35.5f, 44.0f, 30.5f, 48.0f, 0.0f, 0.0f },
+	{ 0, 30.5f, 48.0f, 27.5f, 48.0f, 0.0f, 0.0f },
+	{ 1, 27.5f, 48.0f, 26.5f, 46.0f, 25.5f, 48.0f },
+	{ 0, 25.5f, 48.0f, 0.0f, 47.5f, 0.0f, 0.0f },
+	{ 1, 0.0f, 47.5f, -1.25f, 42.7500038f, 1.0f, 41.5f },
+	{ 0, 1.0f, 41.5f, 0.0f, 40.5f, 0.0f, 0.0f },
+	{ 0, 0.0f, 40.5f, 0.0f, 3.5f, 0.0f, 0.0f },
+	{ 0, 0.0f, 3.5f, 5.5f, 0.0f, 0.0f, 0.0f },
+	{ 0, 18.5f, 1.0f, 18.5f, 2.0f, 0.0f, 0.0f },
+	{ 0, 18.5f, 2.0f, 18.5f, 1.0f, 0.0f, 0.0f },
+	{ 0, 13.5f, 3.0f, 13.5f, 4.0f, 0.0f, 0.0f },
+	{ 0, 13.5f, 4.0f, 13.5f, 3.0f, 0.0f, 0.0f },
+	{ 0, 54.5f, 3.0f, 54.5f, 4.0f, 0.0f, 0.0f },
+	{ 0, 54.5f, 4.0f, 54.5f, 3.0f, 0.0f, 0.0f },
+	{ 0, 8.5f, 5.0f, 8.5f, 6.0f, 0.0f, 0.0f },
+	{ 0, 8.5f, 6.0f, 8.5f, 5.0f, 0.0f, 0.0f },
+	{ 0, 3.5f, 7.0f, 3.5f, 8.0f, 0.0f, 0.0f },
+	{ 0, 3.5f, 8.0f, 3.5f, 7.0f, 0.0f, 0.0f },
+	{ 0, 16.5f, 10.0f, 16.5f, 11.0f, 0.0f, 0.0f },
+	{ 0, 16.5f, 11.0f, 16.5f, 10.0f, 0.0f, 0.0f },
+	{ 0, 11.5f, 12.0f, 11.5f, 13.0f, 0.0f, 0.0f },
+	{ 0, 11.5f, 13.0f, 11.5f, 12.0f, 0.0f, 0.0f },
+	{ 0, 52.5f, 12.0f, 52.5f, 13.0f, 0.0f, 0.0f },
+	{ 0, 52.5f, 13.0f, 52.5f, 12.0f, 0.0f, 0.0f },
+	{ 0, 29.5f, 13.0f, 29.5f, 14.0f, 0.0f, 0.0f },
+	{ 0, 29.5f, 14.0f, 29.5f, 13.0f, 0.0f, 0.0f },
+	{ 0, 6.5f, 14.0f, 6.5f, 15.0f, 0.0f, 0.0f },
+	{ 0, 6.5f, 15.0f, 6.5f, 14.0f, 0.0f, 0.0f },
+	{ 0, 24.5f, 15.0f, 24.5f, 16.0f, 0.0f, 0.0f },
+	{ 0, 24.5f, 16.0f, 24.5f, 15.0f, 0.0f, 0.0f },
+	{ 0, 1.5f, 16.0f, 1.5f, 17.0f, 0.0f, 0.0f },
+	{ 0, 1.5f, 17.0f, 1.5f, 16.0f, 0.0f, 0.0f },
+	{ 0, 37.5f, 18.0f, 37.5f, 19.0f, 0.0f, 0.0f },
+	{ 0, 37.5f, 19.0f, 37.5f, 18.0f, 0.0f, 0.0f },
+	{ 0, 14.5f, 19.0f, 14.5f, 20.0f, 0.0f, 0.0f },
+	{ 0, 14.5f, 20.0f, 14.5f, 19.0f, 0.0f, 0.0f },
+	{ 0, 32.5f, 20.0f, 32.5f, 21.0f, 0.0f, 0.0f },
+	{ 0, 32.5f, 21.0f, 32.5f, 20.0f, 0.0f, 0.0f },
+	{ 0, 9.5f, 21.0f, 9.5f, 22.0f, 0.0f, 0.0f },
+	{ 0, 9.5f, 22.0f, 9.5f, 21.0f, 0.0f, 0.0f },
+	{ 0, 50.5f, 21.0f, 50.5f, 22.0f, 0.0f, 0.0f },
+	{ 0, 50.5f, 22.0f, 50.5f, 21.0f, 0.0f, 0.0f },
+	{ 0, 27.5f, 22.0f, 27.5f, 23.0f, 0.0f, 0.0f },
+	{ 0, 27.5f, 23.0f, 27.5f, 22.0f, 0.0f, 0.0f },
+	{ 0, 4.5f, 23.0f, 4.5f, 24.0f, 0.0f, 0.0f },
+	{ 0, 4.5f, 24.0f, 4.5f, 23.0f, 0.0f, 0.0f },
+	{ 0, 22.5f, 24.0f, 22.5f, 25.0f, 0.0f, 0.0f },
+	{ 0, 22.5f, 25.0f, 22.5f, 24.0f, 0.0f, 0.0f },
+	{ 0, 40.5f, 25.0f, 40.5f, 26.0f, 0.0f, 0.0f },
+	{ 0, 40.5f, 26.0f, 40.5f, 25.0f, 0.0f, 0.0f },
+	{ 0, 58.5f, 26.0f, 58.5f, 27.0f, 0.0f, 0.0f },
+	{ 0, 58.5f, 27.0f, 58.5f, 26.0f, 0.0f, 0.0f },
+	{ 0, 35.5f, 27.0f, 35.5f, 28.0f, 0.0f, 0.0f },
+	{ 0, 35.5f, 28.0f, 35.5f, 27.0f, 0.0f, 0.0f },
+	{ 0, 12.5f, 28.0f, 12.5f, 29.0f, 0.0f, 0.0f },
+	{ 0, 12.5f, 29.0f, 12.5f, 28.0f, 0.0f, 0.0f },
+	{ 0, 30.5f, 29.0f, 30.5f, 30.0f, 0.0f, 0.0f },
+	{ 0, 30.5f, 30.0f, 30.5f, 29.0f, 0.0f, 0.0f },
+	{ 0, 7.5f, 30.0f, 7.5f, 31.0f, 0.0f, 0.0f },
+	{ 0, 7.5f, 31.0f, 7.5f, 30.0f, 0.0f, 0.0f },
+	{ 0, 48.5f, 30.0f, 48.5f, 31.0f, 0.0f, 0.0f },
+	{ 0, 48.5f, 31.0f, 48.5f, 30.0f, 0.0f, 0.0f },
+	{ 0, 25.5f, 31.0f, 25.5f, 32.0f, 0.0f, 0.0f },
+	{ 0, 25.5f, 32.0f, 25.5f, 31.0f, 0.0f, 0.0f },
+	{ 0, 2.5f, 32.0f, 2.5f, 33.0f, 0.0f, 0.0f },
+	{ 0, 2.5f, 33.0f, 2.5f, 32.0f, 0.0f, 0.0f },
+	{ 0, 20.5f, 33.0f, 20.5f, 34.0f, 0.0f, 0.0f },
+	{ 0, 20.5f, 34.0f, 20.5f, 33.0f, 0.0f, 0.0f },
+	{ 0, 61.5f, 33.0f, 61.5f, 34.0f, 0.0f, 0.0f },
+	{ 0, 61.5f, 34.0f, 61.5f, 33.0f, 0.0f, 0.0f },
+	{ 0, 38.5f, 34.0f, 38.5f, 35.0f, 0.0f, 0.0f },
+	{ 0, 38.5f, 35.0f, 38.5f, 34.0f, 0.0f, 0.0f },
+	{ 0, 33.5f, 36.0f, 33.5f, 37.0f, 0.0f, 0.0f },
+	{ 0, 33.5f, 37.0f, 33.5f, 36.0f, 0.0f, 0.0f },
+	{ 0, 10.5f, 37.0f, 10.5f, 38.0f, 0.0f, 0.0f },
+	{ 0, 10.5f, 38.0f, 10.5f, 37.0f, 0.0f, 0.0f },
+	{ 0, 28.5f, 38.0f, 28.5f, 39.0f, 0.0f, 0.0f },
+	{ 0, 28.5f, 39.0f, 28.5f, 38.0f, 0.0f, 0.0f },
+	{ 0, 5.5f, 39.0f, 5.5f, 40.0f, 0.0f, 0.0f },
+	{ 0, 5.5f, 40.0f, 5.5f, 39.0f, 0.0f, 0.0f },
+	{ 0, 46.5f, 39.0f, 46.5f, 40.0f, 0.0f, 0.0f },
+	{ 0, 46.5f, 40.0f, 46.5f, 39.0f, 0.0f, 0.0f },
+	{ 0, 23.5f, 40.0f, 23.5f, 41.0f, 0.0f, 0.0f },
+	{ 0, 23.5f, 41.0f, 23.5f, 40.0f, 0.0f, 0.0f },
+	{ 0, 41.5f, 41.0f, 41.5f, 42.0f, 0.0f, 0.0f },
+	{ 0, 41.5f, 42.0f, 41.5f, 41.0f, 0.0f, 0.0f },
+	{ 0, 18.5f, 42.0f, 18.5f, 43.0f, 0.0f, 0.0f },
+	{ 0, 18.5f, 43.0f, 18.5f, 42.0f, 0.0f, 0.0f },
+	{ 0, 59.5f, 42.0f, 59.5f, 43.0f, 0.0f, 0.0f },
+	{ 0, 59.5f, 43.0f, 59.5f, 42.0f, 0.0f, 0.0f },
+	{ 0, 36.5f, 43.0f, 36.5f, 44.0f, 0.0f, 0.0f },
+	{ 0, 36.5f, 44.0f, 36.5f, 43.0f, 0.0f, 0.0f },
+	{ 0, 31.5f, 45.0f, 31.5f, 46.0f, 0.0f, 0.0f },
+	{ 0, 31.5f, 46.0f, 31.5f, 45.0f, 0.0f, 0.0f },
+	{ 0, 8.5f, 46.0f, 8.5f, 47.0f, 0.0f, 0.0f },
+	{ 0, 8.5f, 47.0f, 8.5f, 46.0f, 0.0f, 0.0f },
+	{ 0, 49.5f, 46.0f, 49.5f, 47.0f, 0.0f, 0.0f },
+	{ 0, 49.5f, 47.0f, 49.5f, 46.0f, 0.0f, 0.0f },
+	{ 0, 47.5f, 0.0f, 64.0f, 0.5f, 0.0f, 0.0f },
+	{ 0, 64.0f, 0.5f, 64.0f, 10.5f, 0.0f, 0.0f },
+	{ 0, 64.0f, 10.5f, 60.5f, 16.0f, 0.0f, 0.0f },
+	{ 0, 60.5f, 16.0f, 60.0f, 10.5f, 0.0f, 0.0f },
+	{ 0, 60.0f, 10.5f, 55.5f, 6.0f, 0.0f, 0.0f },
+	{ 1, 55.5f, 6.0f, 50.7500038f, 7.25000048f, 49.5f, 5.0f },
+	{ 0, 49.5f, 5.0f, 47.5f, 6.0f, 0.0f, 0.0f },
+	{ 0, 47.5f, 6.0f, 47.5f, 0.0f, 0.0f, 0.0f },
+	{ 0, 59.5f, 1.0f, 59.5f, 2.0f, 0.0f, 0.0f },
+	{ 0, 59.5f, 2.0f, 59.5f, 1.0f, 0.0f, 0.0f },
+	{ 0, 13.5f, 3.0f, 13.5f, 4.0f, 0.0f, 0.0f },
+	{ 0, 13.5f, 4.0f, 13.5f, 3.0f, 0.0f, 0.0f },
+	{ 0, 54.5f, 3.0f, 54.5f, 4.0f, 0.0f, 0.0f },
+	{ 0, 54.5f, 4.0f, 54.5f, 3.0f, 0.0f, 0.0f },
+	{ 0, 44.5f, 7.0f, 44.5f, 8.0f, 0.0f, 0.0f },
+	{ 0, 44.5f, 8.0f, 44.5f, 7.0f, 0.0f, 0.0f },
+	{ 0, 62.5f, 8.0f, 62.5f, 9.0f, 0.0f, 0.0f },
+	{ 0, 62.5f, 9.0f, 62.5f, 8.0f, 0.0f, 0.0f },
+	{ 0, 11.5f, 12.0f, 11.5f, 13.0f, 0.0f, 0.0f },
+	{ 0, 11.5f, 13.0f, 11.5f, 12.0f, 0.0f, 0.0f },
+	{ 0, 41.5f, 13.0f, 43.0f, 13.5f, 0.0f, 0.0f },
+	{ 0, 43.0f, 13.5f, 42.5f, 19.0f, 0.0f, 0.0f },
+	{ 0, 42.5f, 19.0f, 38.0f, 15.5f, 0.0f, 0.0f },
+	{ 0, 38.0f, 15.5f, 38.5f, 14.0f, 0.0f, 0.0f },
+	{ 0, 38.5f, 14.0f, 41.5f, 13.0f, 0.0f, 0.0f },
+	{ 0, 9.5f, 21.0f, 9.5f, 22.0f, 0.0f, 0.0f },
+	{ 0, 9.5f, 22.0f, 9.5f, 21.0f, 0.0f, 0.0f },
+	{ 0, 40.5f, 25.0f, 40.5f, 26.0f, 0.0f, 0.0f },
+	{ 0, 40.5f, 26.0f, 40.5f, 25.0f, 0.0f, 0.0f },
+	{ 0, 7.5f, 30.0f, 7.5f, 31.0f, 0.0f, 0.0f },
+	{ 0, 7.5f, 31.0f, 7.5f, 30.0f, 0.0f, 0.0f },
+	{ 0, 38.5f, 34.0f, 38.5f, 35.0f, 0.0f, 0.0f },
+	{ 0, 38.5f, 35.0f, 38.5f, 34.0f, 0.0f, 0.0f },
+	{ 0, 5.5f, 39.0f, 5.5f, 40.0f, 0.0f, 0.0f },
+	{ 0, 5.5f, 40.0f, 5.5f, 39.0f, 0.0f, 0.0f },
+	{ 0, 36.5f, 43.0f, 36.5f, 44.0f, 0.0f, 0.0f },
+	{ 0, 36.5f, 44.0f, 36.5f, 43.0f, 0.0f, 0.0f },
+	{ 0, 26.5f, 0.0f, 40.5f, 0.0f, 0.0f, 0.0f },
+	{ 0, 40.5f, 0.0f, 41.5f, 1.0f, 0.0f, 0.0f },
+	{ 1, 41.5f, 1.0f, 42.5000038f, -0.99999994f, 46.5f, 0.0f },
+	{ 0, 46.5f, 0.0f, 47.0f, 6.5f, 0.0f, 0.0f },
+	{ 1, 47.0f, 6.5f, 42.9166718f, 7.91666603f, 42.5f, 13.0f },
+	{ 1, 42.5f, 13.0f, 39.3333321f, 15.3333302f, 32.5f, 14.0f },
+	{ 0, 32.5f, 14.0f, 27.0f, 9.5f, 0.0f, 0.0f },
+	{ 0, 27.0f, 9.5f, 26.0f, 7.5f, 0.0f, 0.0f },
+	{ 1, 26.0f, 7.5f, 28.0f, 6.5f, 26.0f, 5.5f },
+	{ 0, 26.0f, 5.5f, 26.5f, 0.0f, 0.0f, 0.0f },
+	{ 0, 31.5f, 4.0f, 31.5f, 5.0f, 0.0f, 0.0f },
+	{ 0, 31.5f, 5.0f, 31.5f, 4.0f, 0.0f, 0.0f },
+	{ 0, 3.5f, 7.0f, 3.5f, 8.0f, 0.0f, 0.0f },
+	{ 0, 3.5f, 8.0f, 3.5f, 7.0f, 0.0f, 0.0f },
+	{ 0, 44.5f, 7.0f, 44.5f, 8.0f, 0.0f, 0.0f },
+	{ 0, 44.5f, 8.0f, 44.5f, 7.0f, 0.0f, 0.0f },
+	{ 0, 39.5f, 9.0f, 39.5f, 10.0f, 0.0f, 0.0f },
+	{ 0, 39.5f, 10.0f, 39.5f, 9.0f, 0.0f, 0.0f },
+	{ 0, 1.5f, 16.0f, 1.5f, 17.0f, 0.0f, 0.0f },
+	{ 0, 1.5f, 17.0f, 1.5f, 16.0f, 0.0f, 0.0f },
+	{ 0, 32.5f, 20.0f, 32.5f, 21.0f, 0.0f, 0.0f },
+	{ 0, 32.5f, 21.0f, 32.5f, 20.0f, 0.0f, 0.0f },
+	{ 0, 63.5f, 24.0f, 63.5f, 25.0f, 0.0f, 0.0f },
+	{ 0, 63.5f, 25.0f, 63.5f, 24.0f, 0.0f, 0.0f },
+	{ 0, 30.5f, 29.0f, 30.5f, 30.0f, 0.0f, 0.0f },
+	{ 0, 30.5f, 30.0f, 30.5f, 29.0f, 0.0f, 0.0f },
+	{ 0, 61.5f, 33.0f, 61.5f, 34.0f, 0.0f, 0.0f },
+	{ 0, 61.5f, 34.0f, 61.5f, 33.0f, 0.0f, 0.0f },
+	{ 0, 28.5f, 38.0f, 28.5f, 39.0f, 0.0f, 0.0f },
+	{ 0, 28.5f, 39.0f, 28.5f, 38.0f, 0.0f, 0.0f },
+	{ 0, 59.5f, 42.0f, 59.5f, 43.0f, 0.0f, 0.0f },
+	{ 0, 59.5f, 43.0f, 59.5f, 42.0f, 0.0f, 0.0f },
+	{ 0, 26.5f, 47.0f, 26.5f, 48.0f, 0.0f, 0.0f },
+	{ 0, 26.5f, 48.0f, 26.5f, 47.0f, 0.0f, 0.0f },
+	{ 0, 59.5f, 1.0f, 59.5f, 2.0f, 0.0f, 0.0f },
+	{ 0, 59.5f, 2.0f, 59.5f, 1.0f, 0.0f, 0.0f },
+	{ 0, 26.5f, 6.0f, 26.5f, 7.0f, 0.0f, 0.0f },
+	{ 0, 26.5f, 7.0f, 26.5f, 6.0f, 0.0f, 0.0f },
+	{ 0, 57.5f, 10.0f, 57.5f, 11.0f, 0.0f, 0.0f },
+	{ 0, 57.5f, 11.0f, 57.5f, 10.0f, 0.0f, 0.0f },
+	{ 0, 24.5f, 15.0f, 24.5f, 16.0f, 0.0f, 0.0f },
+	{ 0, 24.5f, 16.0f, 24.5f, 15.0f, 0.0f, 0.0f },
+	{ 0, 55.5f, 19.0f, 55.5f, 20.0f, 0.0f, 0.0f },
+	{ 0, 55.5f, 20.0f, 55.5f, 19.0f, 0.0f, 0.0f },
+	{ 0, 22.5f, 24.0f, 22.5f, 25.0f, 0.0f, 0.0f },
+	{ 0, 22.5f, 25.0f, 22.5f, 24.0f, 0.0f, 0.0f },
+	{ 0, 46.5f, 27.0f, 54.5f, 27.0f, 0.0f, 0.0f },
+	{ 0, 54.5f, 27.0f, 59.0f, 31.5f, 0.0f, 0.0f },
+	{ 0, 59.0f, 31.5f, 59.0f, 39.5f, 0.0f, 0.0f },
+	{ 0, 59.0f, 39.5f, 54.5f, 44.0f, 0.0f, 0.0f },
+	{ 0, 54.5f, 44.0f, 46.5f, 44.0f, 0.0f, 0.0f },
+	{ 0, 46.5f, 44.0f, 42.0f, 39.5f, 0.0f, 0.0f },
+	{ 0, 42.0f, 39.5f, 42.0f, 31.5f, 0.0f, 0.0f },
+	{ 0, 42.0f, 31.5f, 46.5f, 27.0f, 0.0f, 0.0f },
+	{ 0, 48.5f, 30.0f, 48.5f, 31.0f, 0.0f, 0.0f },
+	{ 0, 48.5f, 31.0f, 48.5f, 30.0f, 0.0f, 0.0f },
+	{ 0, 43.5f, 32.0f, 43.5f, 33.0f, 0.0f, 0.0f },
+	{ 0, 43.5f, 33.0f, 43.5f, 32.0f, 0.0f, 0.0f },
+	{ 0, 20.5f, 33.0f, 20.5f, 34.0f, 0.0f, 0.0f },
+	{ 0, 20.5f, 34.0f, 20.5f, 33.0f, 0.0f, 0.0f },
+	{ 0, 56.5f, 35.0f, 56.5f, 36.0f, 0.0f, 0.0f },
+	{ 0, 56.5f, 36.0f, 56.5f, 35.0f, 0.0f, 0.0f },
+	{ 0, 46.5f, 39.0f, 46.5f, 40.0f, 0.0f, 0.0f },
+	{ 0, 46.5f, 40.0f, 46.5f, 39.0f, 0.0f, 0.0f },
+	{ 0, 18.5f, 42.0f, 18.5f, 43.0f, 0.0f, 0.0f },
+	{ 0, 18.5f, 43.0f, 18.5f, 42.0f, 0.0f, 0.0f },
+	{ 1, 35.5f, 46.0f, 38.0f, 47.0f, 36.5f, 48.0f },
+	{ 0, 36.5f, 48.0f, 34.0f, 47.5f, 0.0f, 0.0f },
+	{ 0, 34.0f, 47.5f, 35.5f, 46.0f, 0.0f, 0.0f },
+	{ 0, 49.5f, 46.0f, 49.5f, 47.0f, 0.0f, 0.0f },
+	{ 0, 49.5f, 47.0f, 49.5f, 46.0f, 0.0f, 0.0f },
+	{ 0, 18.5f, 1.0f, 18.5f, 2.0f, 0.0f, 0.0f },
+	{ 0, 18.5f, 2.0f, 18.5f, 1.0f, 0.0f, 0.0f },
+	{ 0, 49.5f, 5.0f, 49.5f, 6.0f, 0.0f, 0.0f },
+	{ 0, 49.5f, 6.0f, 49.5f, 5.0f, 0.0f, 0.0f },
+	{ 0, 16.5f, 10.0f, 16.5f, 11.0f, 0.0f, 0.0f },
+	{ 0, 16.5f, 11.0f, 16.5f, 10.0f, 0.0f, 0.0f },
+	{ 0, 47.5f, 14.0f, 47.5f, 15.0f, 0.0f, 0.0f },
+	{ 0, 47.5f, 15.0f, 47.5f, 14.0f, 0.0f, 0.0f },
+	{ 0, 14.5f, 19.0f, 14.5f, 20.0f, 0.0f, 0.0f },
+	{ 0, 14.5f, 20.0f, 14.5f, 19.0f, 0.0f, 0.0f },
+	{ 0, 45.5f, 23.0f, 45.5f, 24.0f, 0.0f, 0.0f },
+	{ 0, 45.5f, 24.0f, 45.5f, 23.0f, 0.0f, 0.0f },
+	{ 0, 12.5f, 28.0f, 12.5f, 29.0f, 0.0f, 0.0f },
+	{ 0, 12.5f, 29.0f, 12.5f, 28.0f, 0.0f, 0.0f },
+	{ 0, 43.5f, 32.0f, 43.5f, 33.0f, 0.0f, 0.0f },
+	{ 0, 43.5f, 33.0f, 43.5f, 32.0f, 0.0f, 0.0f },
+	{ 0, 10.5f, 37.0f, 10.5f, 38.0f, 0.0f, 0.0f },
+	{ 0, 10.5f, 38.0f, 10.5f, 37.0f, 0.0f, 0.0f },
+	{ 0, 41.5f, 41.0f, 41.5f, 42.0f, 0.0f, 0.0f },
+	{ 0, 41.5f, 42.0f, 41.5f, 41.0f, 0.0f, 0.0f },
+	{ 0, 35.5f, 44.0f, 36.0f, 45.5f, 0.0f, 0.0f },
+	{ 1, 36.0f, 45.5f, 35.5f, 48.5000038f, 31.5f, 48.0f },
+	{ 1, 31.5f, 48.0f, 30.0f, 47.0f, 32.5f, 46.0f },
+	{ 0, 32.5f, 46.0f, 35.5f, 44.0f, 0.0f, 0.0f },
+	{ 0, 8.5f, 46.0f, 8.5f, 47.0f, 0.0f, 0.0f },
+	{ 0, 8.5f, 47.0f, 8.5f, 46.0f, 0.0f, 0.0f },
+	{ 0, 41.5f, 0.0f, 41.5f, 1.0f, 0.0f, 0.0f },
+	{ 0, 41.5f, 1.0f, 41.5f, 0.0f, 0.0f, 0.0f },
+	{ 0, 8.5f, 5.0f, 8.5f, 6.0f, 0.0f, 0.0f },
+	{ 0, 8.5f, 6.0f, 8.5f, 5.0f, 0.0f, 0.0f },
+	{ 0, 39.5f, 9.0f, 39.5f, 10.0f, 0.0f, 0.0f },
+	{ 0, 39.5f, 10.0f, 39.5f, 9.0f, 0.0f, 0.0f },
+	{ 0, 6.5f, 14.0f, 6.5f, 15.0f, 0.0f, 0.0f },
+	{ 0, 6.5f, 15.0f, 6.5f, 14.0f, 0.0f, 0.0f },
+	{ 0, 37.5f, 18.0f, 37.5f, 19.0f, 0.0f, 0.0f },
+	{ 0, 37.5f, 19.0f, 37.5f, 18.0f, 0.0f, 0.0f },
+	{ 0, 4.5f, 23.0f, 4.5f, 24.0f, 0.0f, 0.0f },
+	{ 0, 4.5f, 24.0f, 4.5f, 23.0f, 0.0f, 0.0f },
+	{ 0, 35.5f, 27.0f, 35.5f, 28.0f, 0.0f, 0.0f },
+	{ 0, 35.5f, 28.0f, 35.5f, 27.0f, 0.0f, 0.0f },
+	{ 0, 2.5f, 32.0f, 2.5f, 33.0f, 0.0f, 0.0f },
+	{ 0, 2.5f, 33.0f, 2.5f, 32.0f, 0.0f, 0.0f },
+	{ 0, 33.5f, 36.0f, 33.5f, 37.0f, 0.0f, 0.0f },
+	{ 0, 33.5f, 37.0f, 33.5f, 36.0f, 0.0f, 0.0f },
+	{ 0, 0.5f, 41.0f, 0.5f, 42.0f, 0.0f, 0.0f },
+	{ 0, 0.5f, 42.0f, 0.5f, 41.0f, 0.0f, 0.0f },
+	{ 0, 31.5f, 45.0f, 31.5f, 46.0f, 0.0f, 0.0f },
+	{ 0, 31.5f, 46.0f, 31.5f, 45.0f, 0.0f, 0.0f },
+};